@@ -22,6 +22,296 @@
 #include "HAL.h"
 #include "llamsis.h"
 
+/*
+ * Niveles de los mensajes del registro del nucleo. Los mensajes se
+ * guardan en un buffer circular de TAM_BUF_LOG bytes, que se vuelca en
+ * pantalla cuando el procesador esta ocioso y se puede leer con leer_klog.
+ * Las llamadas de nivel inferior a NIVEL_LOG_MIN no generan codigo (el
+ * compilador solo comprueba sus argumentos). NIVEL_LOG_MIN se fija al
+ * compilar, p.ej. make NIVEL_LOG=0 para incluir las de depuracion.
+ */
+#define LOG_DEPURA 0
+#define LOG_INFO 1
+#define LOG_AVISO 2
+#define LOG_ERROR 3
+
+#ifndef NIVEL_LOG_MIN
+#define NIVEL_LOG_MIN LOG_INFO
+#endif
+
+#define TAM_BUF_LOG 8192
+#define TAM_MENSAJE_LOG 160	/* tamano maximo de cada mensaje */
+
+void klog(int nivel, const char *formato, ...);
+
+#if NIVEL_LOG_MIN <= LOG_DEPURA
+#define klog_depura(...) klog(LOG_DEPURA, __VA_ARGS__)
+#else
+#define klog_depura(...) do { if (0) klog(0, __VA_ARGS__); } while (0)
+#endif
+
+#if NIVEL_LOG_MIN <= LOG_INFO
+#define klog_info(...) klog(LOG_INFO, __VA_ARGS__)
+#else
+#define klog_info(...) do { if (0) klog(0, __VA_ARGS__); } while (0)
+#endif
+
+#if NIVEL_LOG_MIN <= LOG_AVISO
+#define klog_aviso(...) klog(LOG_AVISO, __VA_ARGS__)
+#else
+#define klog_aviso(...) do { if (0) klog(0, __VA_ARGS__); } while (0)
+#endif
+
+#define klog_error(...) klog(LOG_ERROR, __VA_ARGS__)
+
+/*
+ * Variables globales del registro del nucleo: el buffer circular, los
+ * bytes escritos en total, los que ya se han volcado en pantalla y los
+ * que se han perdido sin volcar porque se sobrescribieron
+ */
+char buf_log[TAM_BUF_LOG];
+unsigned int log_escritos=0;
+unsigned int log_volcados=0;
+unsigned int log_perdidos=0;
+
+/*
+ * Cola de salida del sistema. escribir copia el texto en ella y vuelve sin
+ * esperar al terminal; se vacia en pantalla cuando el procesador esta
+ * ocioso y, de SALIDA_POR_TICK en SALIDA_POR_TICK bytes, en cada
+ * interrupcion de reloj. Un proceso solo se bloquea si la cola esta llena,
+ * hasta que baja de MARCA_BAJA_SALIDA.
+ */
+#define TAM_COLA_SALIDA 4096
+#define MARCA_BAJA_SALIDA (TAM_COLA_SALIDA/2)
+#define SALIDA_POR_TICK 256
+
+char cola_salida[TAM_COLA_SALIDA];
+unsigned int salida_encolados=0;	/* bytes encolados en total */
+unsigned int salida_volcados=0;		/* bytes ya escritos en pantalla */
+
+/*
+ * Buffer del terminal. int_terminal guarda en el los caracteres que llegan
+ * y los lectores los sacan; si esta lleno, el caracter se pierde y se
+ * cuenta en term_perdidos. Su tamano es TAM_BUF_TERM (const.h) salvo que
+ * se fije otro al compilar (TAM_TERM en minikernel/Makefile).
+ */
+#ifndef TAM_BUF_TERMINAL
+#define TAM_BUF_TERMINAL TAM_BUF_TERM
+#endif
+
+char buf_term[TAM_BUF_TERMINAL];
+unsigned int term_recibidos=0;	/* caracteres guardados en total */
+unsigned int term_leidos=0;	/* caracteres ya sacados por los lectores */
+unsigned int term_perdidos=0;	/* caracteres perdidos por buffer lleno */
+
+/*
+ * Estadisticas del terminal que devuelve estad_terminal.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+typedef struct {
+	unsigned int recibidos;		/* caracteres guardados en el buffer */
+	unsigned int leidos;		/* caracteres entregados a los lectores */
+	unsigned int perdidos;		/* caracteres perdidos (buffer lleno) */
+	unsigned int pendientes;	/* caracteres en el buffer ahora */
+} estad_term;
+
+/*
+ * Funcion de la biblioteca de usuario que devuelve la direccion de la
+ * variable en la que el nucleo deja el id del proceso que va a ejecutar,
+ * para que la biblioteca sepa sin una llamada que proceso la esta usando
+ */
+#define FUNC_ID_USUARIO "dir_id_proc_actual"
+
+/*
+ * Funcion de la biblioteca de usuario que devuelve la direccion de la
+ * variable en la que el nucleo deja las palabras de los mutex abiertos
+ * por el proceso que va a ejecutar (una tabla_palabras, con NULL en los
+ * descriptores que no estan abiertos), para que lock y unlock no entren en
+ * el nucleo si no hace falta
+ */
+#define FUNC_PALABRAS_USUARIO "dir_palabras_proc_actual"
+
+/*
+ * Estado de un proceso terminado cuya imagen y pila aun no se han
+ * liberado. Su entrada en la tabla de procesos sigue ocupada.
+ */
+#define ZOMBI 4
+
+/*
+ * Valor del campo espera_hijo cuando el proceso no esta esperando a
+ * ningun hijo (-1 significa esperar a cualquiera)
+ */
+#define NO_ESPERA -2
+
+/*
+ * Estado de terminacion de un proceso que muere por una excepcion
+ */
+#define FIN_EXCEPCION -1
+
+/*
+ * Estados de terminacion de un proceso que el nucleo mata por superar
+ * alguno de sus limites (ver fijar_limites)
+ */
+#define FIN_LIMITE_CPU -10
+#define FIN_LIMITE_HIJOS -11
+#define FIN_LIMITE_MUTEX -12
+#define FIN_LIMITE_PILA -13
+
+/*
+ * Prioridades de los procesos (mayor valor, mas prioridad) y tamano
+ * minimo de pila que se admite en crear_proceso_ext
+ */
+#define PRIO_MIN 1
+#define PRIO_DEFECTO 10
+#define PRIO_MAX 20
+
+#define TAM_PILA_MIN 8192
+
+/*
+ * Atributos de crear_proceso_ext. Un campo a 0 indica valor por defecto.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+typedef struct {
+	int tam_pila;		/* tamano de la pila en bytes */
+	int prioridad;		/* prioridad inicial (PRIO_MIN..PRIO_MAX) */
+	int rodaja;		/* ticks por rodaja */
+	int argc;		/* numero de argumentos */
+	char **argv;		/* argumentos que se copian en la pila */
+} atrib_proceso;
+
+/*
+ * Limites de recursos de un proceso. Un campo a 0 indica sin limite.
+ * Los hereda cada proceso o hilo que crea.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+typedef struct {
+	int max_ticks;		/* ticks de UCP que puede consumir */
+	int max_hijos;		/* hijos sin recoger que puede tener */
+	int max_mutex;		/* descriptores de mutex abiertos */
+	int max_pila;		/* tamano de pila de los procesos que crea */
+} limites_proceso;
+
+/*
+ * Anillos de envio y de finalizacion de operaciones asincronas (ver
+ * registrar_anillos y enviar_anillo). Estan en la memoria del proceso:
+ * en cada anillo uno de los dos lados avanza la cola al producir y el
+ * otro la cabeza al consumir.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+#define TAM_ANILLO 16		/* entradas de cada anillo */
+
+#define OP_LOCK 0		/* arg1: descriptor del mutex */
+#define OP_DORMIR 1		/* arg1: segundos */
+#define OP_LEER_CAR 2		/* resultado: caracter leido */
+#define OP_ESCRIBIR 3		/* arg1: texto, arg2: longitud */
+
+typedef struct {
+	int op;			/* operacion OP_... */
+	long arg1;		/* parametros */
+	long arg2;
+	long dato;		/* valor del usuario que se copia al terminar */
+} peticion_anillo;
+
+typedef struct {
+	long dato;		/* el de la peticion */
+	long resultado;		/* resultado de la operacion */
+} fin_anillo;
+
+typedef struct {
+	volatile unsigned int cabeza;	/* siguiente a consumir (nucleo) */
+	volatile unsigned int cola;	/* siguiente a rellenar (usuario) */
+	peticion_anillo entradas[TAM_ANILLO];
+} anillo_envio;
+
+typedef struct {
+	volatile unsigned int cabeza;	/* siguiente a consumir (usuario) */
+	volatile unsigned int cola;	/* siguiente a rellenar (nucleo) */
+	fin_anillo entradas[TAM_ANILLO];
+} anillo_fin;
+
+/*
+ * Conjunto de eventos de esperar_eventos: el bit i (i < NUM_MUT_PROC)
+ * representa el descriptor de mutex i, que esta listo si lock no
+ * bloquearia, y EV_TERMINAL que hay caracteres en el buffer del terminal.
+ * Deben coincidir con las definiciones de usuario/include/servicios.h
+ */
+#define EV_MUTEX(desc) (1<<(desc))
+#define EV_TERMINAL (1<<NUM_MUT_PROC)
+#define MAX_ESPERAS_EV (NUM_MUT_PROC+1)
+
+/*
+ * Palabra de un mutex visible desde la biblioteca de usuario, que la usa
+ * para bloquearlo y desbloquearlo sin entrar en el nucleo cuando nadie
+ * espera por el. estado vale 0 si esta libre y, si no, el id de su dueno
+ * mas 1, con el bit MUTEX_ESPERAS si hay algo esperando en el nucleo (y
+ * entonces unlock tiene que entrar en el). Solo el dueno cambia bloqueos.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+#define MUTEX_ESPERAS 0x40000000
+#define MUTEX_DUENO(estado) ((estado) & ~MUTEX_ESPERAS)
+
+typedef struct {
+	volatile int estado;	/* 0 o id del dueno + 1 (| MUTEX_ESPERAS) */
+	int tipo;		/* RECURSIVO o NO_RECURSIVO */
+	int bloqueos;		/* veces que lo tiene bloqueado su dueno */
+} palabra_mutex;
+
+/*
+ * Descriptores de mutex de un grupo de procesos. La tabla crece por
+ * bloques de DESC_POR_BLOQUE descriptores, que se reservan al usar el
+ * primero de cada bloque y no se liberan hasta que termina el grupo, por
+ * lo que la biblioteca puede leer sus palabras en cualquier momento. Un
+ * grupo puede tener abiertos LIMITE_DESC_MUTEX: NUM_MUT_PROC (const.h)
+ * salvo que se fije otro al compilar (DESC_MUTEX en minikernel/Makefile),
+ * sin pasar de 32*32, que es lo que cubre el mapa de bits con el que se
+ * busca el descriptor libre mas bajo (una palabra por cada 32 descriptores
+ * y otra con las palabras que estan llenas). esperar_eventos solo admite
+ * los NUM_MUT_PROC primeros.
+ * DESC_POR_BLOQUE debe coincidir con usuario/include/servicios.h
+ */
+#ifndef LIMITE_DESC_MUTEX
+#define LIMITE_DESC_MUTEX NUM_MUT_PROC
+#endif
+#if LIMITE_DESC_MUTEX > 32*32
+#error "LIMITE_DESC_MUTEX no puede pasar de 1024"
+#endif
+#define DESC_POR_BLOQUE 8
+#define MAX_BLOQUES_DESC ((LIMITE_DESC_MUTEX+DESC_POR_BLOQUE-1)/DESC_POR_BLOQUE)
+#define PALABRAS_MAPA_DESC ((LIMITE_DESC_MUTEX+31)/32)
+
+typedef struct {
+	int posicion[DESC_POR_BLOQUE];	/* en la tabla de mutex (-1 si libre) */
+	palabra_mutex *palabra[DESC_POR_BLOQUE];	/* su palabra (solo mutex) */
+} bloque_desc;
+
+/*
+ * Palabras de los mutex abiertos por un grupo tal como se publican a la
+ * biblioteca de usuario: por cada bloque de descriptores reservado, el
+ * vector de palabras de ese bloque.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+typedef struct {
+	int num_bloques;		/* bloques reservados */
+	palabra_mutex ***bloques;	/* palabras de cada bloque */
+} tabla_palabras;
+
+/*
+ * Registro de espera de esperar_eventos, que engancha un proceso a la
+ * lista de una fuente (un mutex o el terminal). Cada proceso tiene los
+ * suyos en el BCP, por lo que registrarlos y cancelarlos es solo enlazar
+ * y desenlazar, sin reservar nada.
+ */
+typedef struct espera_ev_t {
+	struct BCP_t *proc;		/* proceso que espera */
+	struct lista_esperas_t *lista;	/* lista en la que esta (o NULL) */
+	struct espera_ev_t *anterior;
+	struct espera_ev_t *siguiente;
+} espera_ev;
+
+typedef struct lista_esperas_t {
+	espera_ev *primero;
+} lista_esperas;
+
 /*
  *
  * Definicion del tipo que corresponde con el BCP.
@@ -32,16 +322,73 @@ typedef struct BCP_t *BCPptr;
 
 typedef struct BCP_t {
         int id;				/* ident. del proceso */
-        int estado;			/* TERMINADO|LISTO|EJECUCION|BLOQUEADO*/
+        int estado;			/* TERMINADO|LISTO|EJECUCION|BLOQUEADO|ZOMBI*/
         contexto_t contexto_regs;	/* copia de regs. de UCP */
         void * pila;			/* dir. inicial de la pila */
+        int tam_pila;			/* tamano de la pila */
 		int segs_restantes;  /* segundos que le quedan al proceso para despertarse*/
 		BCPptr siguiente;		/* puntero a otro BCP */
 		void *info_mem;			/* descriptor del mapa de memoria */
 		int TICKS_por_rodaja; /* Tick que tiene cada rodaja*/
+		int rodaja;		/* ticks de cada rodaja del proceso */
+		int prioridad;		/* prioridad efectiva (la que usa el planificador) */
+		int prioridad_base;	/* la suya, sin la heredada por los mutex */
+		struct Mutex_t *mutex_espera;	/* mutex por el que espera en lock */
+		int argc;		/* numero de argumentos */
+		char **argv;		/* argumentos (en la cima de la pila) */
 
-		int descriptores[NUM_MUT_PROC];
+		bloque_desc *bloques_desc[MAX_BLOQUES_DESC];	/* (lider) descriptores
+							   de mutex, por bloques */
+		int num_bloques_desc;	/* (lider) bloques reservados (siempre los
+					   primeros) */
+		unsigned int desc_ocupados[PALABRAS_MAPA_DESC];	/* (lider) mapa de
+							   bits de los usados */
+		unsigned int desc_llenas;	/* (lider) palabras del mapa sin
+						   bits libres */
 		int descriptores_abiertos;
+
+		BCPptr padre;		/* proceso que lo creo (NULL si ya lo recogio) */
+		int estado_fin;		/* estado con el que termino el proceso */
+		int espera_hijo;	/* hijo esperado en esperar_proceso */
+		int hijo_recogido;	/* hijo que desperto al proceso */
+		int estado_hijo;	/* estado de terminacion de ese hijo */
+
+		BCPptr lider;		/* proceso dueno de la imagen y los mutex */
+		int miembros;		/* (lider) procesos vivos del grupo */
+		void *func_hilo;	/* (hilo) funcion que ejecuta */
+		void *arg_hilo;		/* (hilo) argumento de esa funcion */
+
+		anillo_envio *anillo_env;	/* anillos registrados (o NULL) */
+		anillo_fin *anillo_fin;
+		int en_vuelo;		/* operaciones asincronas sin terminar */
+		int espera_fin;		/* finalizaciones esperadas en enviar_anillo */
+
+		int ticks_plazo;	/* ticks que le quedan de espera con plazo */
+		struct lista_BCPs_t *lista_plazo; /* lista en la que espera con plazo */
+		int plazo_vencido;	/* se desperto porque vencio el plazo */
+
+		limites_proceso limites;	/* limites de recursos */
+		int ticks_cpu;		/* ticks de UCP consumidos */
+		int fin_pendiente;	/* estado con el que int_sw lo debe terminar */
+
+		int *id_usuario;	/* variable de la biblioteca de usuario con el
+					   id del proceso en ejecucion (o NULL) */
+		tabla_palabras **palabras_usuario; /* y con sus palabras de mutex */
+		palabra_mutex **palabras_bloque[MAX_BLOQUES_DESC]; /* (lider) las de
+							   cada bloque */
+		tabla_palabras palabras;	/* (lider) la que se publica */
+
+		espera_ev esperas_ev[MAX_ESPERAS_EV];	/* (esperar_eventos) */
+
+		int *lecturas[MAX_BLOQUES_DESC];	/* (rwlock) lecturas que tiene por
+						   cada descriptor del grupo, por
+						   bloques (NULL si ninguna) */
+		int lectura_espera;	/* (rwlock) descriptor por el que espera leer */
+		int concedido;	/* (semaforo, barrera) otro proceso le ha
+				   dado paso, (mutex) un unlock le ha
+				   despertado para competir por el */
+		struct Mutex_t *mutex_cond;	/* (condicion) mutex que ha soltado
+						   en cond_wait */
 } BCP;
 
 /*
@@ -52,19 +399,151 @@ typedef struct BCP_t {
  *
  */
 
-typedef struct{
+typedef struct lista_BCPs_t{
 	BCP *primero;
 	BCP *ultimo;
 } lista_BCPs;
 
+/*
+ * Operacion asincrona que el nucleo tiene pendiente de completar. Esta
+ * en la lista de lo que espera (un mutex, el reloj o el terminal).
+ */
+#define MAX_PET_ASYNC 32
+
+typedef struct pet_async_t *pet_asyncptr;
+
+typedef struct lista_async_t{
+	pet_asyncptr primero;
+	pet_asyncptr ultimo;
+} lista_async;
+
+typedef struct pet_async_t {
+	BCP *proc;		/* proceso que la envio (NULL si esta libre) */
+	int op;			/* operacion OP_... */
+	long arg1;		/* (OP_LOCK) posicion del mutex */
+	long dato;		/* valor del usuario */
+	int ticks_restantes;	/* (OP_DORMIR) */
+	lista_async *lista;	/* lista en la que esta */
+	pet_asyncptr siguiente;
+} pet_async;
+
+/*
+ * Estadisticas de contencion de un mutex (lockstat). Solo se recogen
+ * mientras lockstat esta activo y entonces la biblioteca de usuario no
+ * coge ni suelta los mutex por su cuenta, para que todo pase por el
+ * nucleo. Los tiempos se miden con leer_reloj_CMOS (en ms). Se ponen a
+ * cero al crear el mutex y se mantienen despues de destruirlo hasta que
+ * se reutiliza su entrada de la tabla de mutex.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+typedef struct {
+	char nombre[MAX_NOM_MUT+1];	/* del mutex */
+	unsigned int adquisiciones;	/* veces que ha pasado a tener dueno */
+	unsigned int contendidas;	/* locks que lo consiguen tras esperar */
+	unsigned int reentradas;	/* locks de un recursivo que ya es suyo */
+	unsigned int espera_total;	/* ms esperados por esos locks */
+	unsigned int espera_max;
+	unsigned int retencion_total;	/* ms que lo han tenido sus duenos */
+	unsigned int retencion_max;
+	unsigned int max_esperando;	/* maximo de procesos esperando */
+} estad_mutex;
+
+/*
+ * Modos de estad_cerrojos, que se pueden combinar. Lo que se pide se
+ * hace despues de copiar las estadisticas.
+ * Deben coincidir con las definiciones de usuario/include/servicios.h
+ */
+#define LOCKSTAT_ACTIVAR 1	/* empieza a recogerlas */
+#define LOCKSTAT_PARAR 2	/* deja de recogerlas */
+#define LOCKSTAT_REINICIAR 4	/* las pone a cero */
+
+/*
+ * Politicas de un mutex al soltarlo cuando hay procesos esperando. Con
+ * POLITICA_ENTREGA (la de por defecto) pasa directamente al primero, que
+ * es justo pero lo deja con dueno aunque este tarde en ejecutar. Con
+ * POLITICA_COMPETIR queda libre y el primero se despierta para intentarlo
+ * de nuevo, asi que puede cogerlo antes quien este ejecutando. Para que
+ * no se quede sin el, tras MAX_ADELANTOS veces seguidas que lo intenta y
+ * lo encuentra cogido, el siguiente unlock se lo entrega.
+ * Deben coincidir con las definiciones de usuario/include/servicios.h
+ */
+#define POLITICA_ENTREGA 0
+#define POLITICA_COMPETIR 1
+#define MAX_ADELANTOS 4
+
+/*
+ * Tabla de mutex del sistema. Crece por bloques de MUTEX_POR_BLOQUE
+ * entradas, que se reservan cuando no queda ninguna libre, hasta tener
+ * LIMITE_MUTEX: NUM_MUT (const.h) salvo que se fije otro al compilar
+ * (NUM_MUTEX en minikernel/Makefile). Solo al llegar a ese limite se
+ * bloquean los que crean mutex. Los bloques no se liberan, por lo que una
+ * entrada no cambia de sitio y se identifica por su posicion (MUTEX_EN).
+ * Los nombres se buscan en una tabla hash de TAM_HASH_MUTEX cubos
+ * encadenados por el campo siguiente de la entrada, que en las libres las
+ * encadena en la lista de entradas libres.
+ */
+#ifndef LIMITE_MUTEX
+#define LIMITE_MUTEX NUM_MUT
+#endif
+#define MUTEX_POR_BLOQUE 8
+#define MAX_BLOQUES_MUTEX ((LIMITE_MUTEX+MUTEX_POR_BLOQUE-1)/MUTEX_POR_BLOQUE)
+#define TAM_HASH_MUTEX LIMITE_MUTEX
+#define MUTEX_EN(pos) \
+	(bloques_mutex[(pos)/MUTEX_POR_BLOQUE][(pos)%MUTEX_POR_BLOQUE])
+
+/*
+ * Clases de entrada de la tabla de mutex. Los cerrojos de lectores y
+ * escritores (rwlock), los semaforos y las variables condicion comparten
+ * con los mutex la tabla, los nombres y los descriptores, pero solo se
+ * manejan con sus propias llamadas:
+ *	- rwlock: el escritor es el dueno de la palabra y espera en
+ *	  lista_espera, y los lectores se cuentan en lectores y esperan en
+ *	  lista_lectores.
+ *	- semaforo: su contador es valor y los que esperan estan en
+ *	  lista_espera.
+ *	- condicion: los que esperan estan en lista_espera y cada uno tiene
+ *	  en su BCP el mutex que ha soltado.
+ *	- barrera: valor es el numero de participantes y los que han llegado
+ *	  esperan en lista_espera.
+ */
+#define CLASE_MUTEX 0
+#define CLASE_RWLOCK 1
+#define CLASE_SEMAFORO 2
+#define CLASE_CONDICION 3
+#define CLASE_BARRERA 4
+
+/*
+ * Politicas de los rwlock: con PREF_ESCRITOR un lector nuevo espera si
+ * hay algun escritor esperando, para que estos no se queden sin entrar
+ * nunca; con PREF_LECTOR solo si hay un escritor dentro.
+ * Deben coincidir con las definiciones de usuario/include/servicios.h
+ */
+#define PREF_ESCRITOR 0
+#define PREF_LECTOR 1
+
 typedef struct Mutex_t{
-	int tipo;
-	char nombre[MAX_NOM_MUT];
+	palabra_mutex palabra;	/* dueno, tipo y bloqueos */
+	char nombre[MAX_NOM_MUT+1];
 	int estado;
-	int num_bloqueos;
+	int clase;		/* CLASE_MUTEX o CLASE_RWLOCK */
 	int num_procesos_esperando;
 	lista_BCPs lista_espera;
-	BCP * proc_mut;
+	int preferencia;	/* (rwlock) PREF_ESCRITOR o PREF_LECTOR */
+	int lectores;		/* (rwlock) lecturas concedidas */
+	lista_BCPs lista_lectores;	/* (rwlock) lectores que esperan */
+	int valor;		/* (semaforo) unidades disponibles,
+				   (barrera) participantes */
+	int politica;		/* (mutex) POLITICA_ENTREGA o POLITICA_COMPETIR */
+	int adelantos;		/* (mutex) veces seguidas que el despertado lo
+				   ha encontrado cogido */
+	lista_async lista_espera_async;	/* OP_LOCK pendientes */
+	lista_esperas esperas_ev;	/* esperar_eventos pendientes */
+	int abiertos;		/* descriptores que lo tienen abierto */
+	int siguiente;		/* siguiente del cubo o de libres (-1: fin) */
+	estad_mutex estad;	/* (lockstat) estadisticas de contencion */
+	unsigned long long inicio_retencion;	/* (lockstat) ms en que lo
+						   cogio su dueno (0 si no
+						   se sabe) */
 	//int proc_abiertos;
 } Mutex;
 
@@ -89,15 +568,79 @@ lista_BCPs lista_listos= {NULL, NULL};
  */
 lista_BCPs lista_dormidos= {NULL, NULL};
 
+/*
+ * Variable global que representa la cola de procesos terminados pendientes
+ * de liberar su imagen y su pila
+ */
+lista_BCPs lista_zombis= {NULL, NULL};
+
+/*
+ * Variable global que representa la cola de procesos bloqueados esperando
+ * a que termine alguno de sus hijos
+ */
+lista_BCPs lista_espera_hijos= {NULL, NULL};
+
+/*
+ * Variable global que representa la cola de procesos bloqueados en
+ * crear_proceso_esp esperando a que quede libre una entrada de la tabla
+ * de procesos, y cuantos hay en ella (como mucho MAX_ESPERA_BCP)
+ */
+#define MAX_ESPERA_BCP 8
+
+lista_BCPs lista_espera_BCP= {NULL, NULL};
+int num_espera_BCP=0;
+
+/*
+ * Variable global que representa la cola de procesos bloqueados en
+ * escribir porque la cola de salida esta llena
+ */
+lista_BCPs lista_espera_salida= {NULL, NULL};
+
+/*
+ * Variable global que representa la cola de procesos bloqueados leyendo
+ * del terminal porque su buffer esta vacio
+ */
+lista_BCPs lista_espera_term= {NULL, NULL};
+
+/*
+ * Variables globales que representan la cola de procesos bloqueados en
+ * esperar_eventos y los registros de espera de los que esperan al terminal
+ */
+lista_BCPs lista_espera_eventos= {NULL, NULL};
+lista_esperas esperas_ev_term= {NULL};
+
+/*
+ * Variable global que representa la cola de procesos bloqueados en
+ * enviar_anillo esperando finalizaciones
+ */
+lista_BCPs lista_espera_anillo= {NULL, NULL};
+
+/*
+ * Variables globales que representan las operaciones asincronas: la
+ * tabla de la que se reservan y las que esperan al reloj o al terminal
+ */
+pet_async tabla_async[MAX_PET_ASYNC];
+lista_async lista_async_dormir= {NULL, NULL};
+lista_async lista_async_leer= {NULL, NULL};
+
 /*
  * Variable global que representa procesos que seran expulsados por round robin
  */
 BCP * p_proc_a_expulsar=NULL;
 
 /*
- * Variable global que representa los mutex
+ * Variables globales que representan los mutex: los bloques de la tabla
+ * reservados hasta ahora
  */
-Mutex sis_lista_mutex[NUM_MUT];
+Mutex *bloques_mutex[MAX_BLOQUES_MUTEX];
+int num_bloques_mutex=0;
+
+/*
+ * Variables globales que representan el indice de nombres de mutex (la
+ * primera entrada de cada cubo) y la lista de entradas libres
+ */
+int hash_mutex[TAM_HASH_MUTEX];
+int primer_mutex_libre=-1;
 
 /*
  * Variable global que representa la lista de procesos bloqueados
@@ -107,13 +650,64 @@ lista_BCPs lista_bloqueados_mutex= {NULL, NULL};
 /*
  *
  * Definici�n del tipo que corresponde con una entrada en la tabla de
- * llamadas al sistema.
+ * llamadas al sistema. bloquearia indica si la llamada, con los
+ * parametros que hay en los registros, bloquearia al proceso o no
+ * volveria (NULL si nunca lo hace). La usa llamsis_lote.
  *
  */
 typedef struct{
 	int (*fservicio)();
+	int (*bloquearia)();
 } servicio;
 
+/*
+ * Entrada del vector que recibe llamsis_lote.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+#define NARGS_LOTE 5	/* registros 1 a NREGS-1 */
+
+typedef struct {
+	int servicio;			/* numero de la llamada */
+	long args[NARGS_LOTE];		/* parametros */
+	long resultado;			/* valor devuelto por la llamada */
+} op_lote;
+
+/*
+ * Estadisticas de uso de una llamada al sistema. La latencia se mide con
+ * leer_reloj_CMOS (en ms) e incluye el tiempo que el proceso pasa
+ * bloqueado; el cubo i del histograma cuenta las llamadas que tardan
+ * menos de 2^i ms (el ultimo, el resto). Las llamadas que no vuelven
+ * (terminar_proceso) solo se cuentan en llamadas.
+ * Debe coincidir con la definicion de usuario/include/servicios.h
+ */
+#define NUM_CUBOS_LAT 8
+
+typedef struct {
+	unsigned int llamadas;		/* veces que se ha invocado */
+	unsigned int errores;		/* veces que ha devuelto un valor < 0 */
+	unsigned int lat_total;		/* suma de latencias (ms) */
+	unsigned int lat_max;		/* latencia maxima (ms) */
+	unsigned int hist[NUM_CUBOS_LAT];	/* histograma de latencias */
+} estad_servicio;
+
+/*
+ * Variables globales con las estadisticas de las llamadas al sistema: en
+ * total y por proceso. Las de un proceso se mantienen despues de terminar
+ * hasta que se reutiliza su entrada de la tabla de procesos.
+ */
+estad_servicio estad_total[NSERVICIOS];
+estad_servicio estad_proc[MAX_PROC][NSERVICIOS];
+
+/*
+ * Variable global que indica si lockstat esta activo
+ */
+int lockstat_activo=0;
+
+/*
+ * Variable global con el instante de arranque del sistema (en ms)
+ */
+unsigned long long int tiempo_arranque;
+
 
 /*
  * Prototipos de las rutinas que realizan cada llamada al sistema
@@ -128,19 +722,119 @@ int sis_abrirMutex();
 int sis_lockMutex();
 int sis_unlockMutex();
 int sis_cerrarMutex();
+int sis_esperar_proceso();
+int sis_ejecutar();
+int sis_crear_hilo();
+int sis_args_hilo();
+int sis_crear_proceso_ext();
+int sis_obtener_args();
+int sis_llamsis_lote();
+int sis_obtener_tiempo();
+int sis_registrar_anillos();
+int sis_enviar_anillo();
+int sis_estad_llamsis();
+int sis_crear_proceso_esp();
+int sis_fijar_limites();
+int sis_obtener_limites();
+int sis_leer_klog();
+int sis_leer_caracter();
+int sis_leer_linea();
+int sis_leer();
+int sis_estad_terminal();
+int sis_esperar_eventos();
+int sis_trylockMutex();
+int sis_crear_rwlock();
+int sis_abrir_rwlock();
+int sis_lock_lectura();
+int sis_lock_escritura();
+int sis_unlock_rw();
+int sis_crear_semaforo();
+int sis_abrir_semaforo();
+int sis_sem_bajar();
+int sis_sem_subir();
+int sis_crear_condicion();
+int sis_abrir_condicion();
+int sis_cond_wait();
+int sis_cond_signal();
+int sis_cond_broadcast();
+int sis_crear_barrera();
+int sis_abrir_barrera();
+int sis_esperar_barrera();
+int sis_estad_cerrojos();
+int sis_fijar_politica_mutex();
+int sis_lock_timeout();
+
+/*
+ * Prototipos de las rutinas que indican si una llamada bloquearia
+ */
+int bloquea_siempre();
+int bloquearia_crearMutex();
+int bloquearia_lockMutex();
+int bloquearia_enviar_anillo();
+int bloquearia_escribir();
+int bloquearia_leer_term();
+int bloquearia_leer_linea();
+int bloquearia_esperar_eventos();
+int bloquearia_lock_timeout();
+int bloquearia_lock_lectura();
+int bloquearia_lock_escritura();
+int bloquearia_sem_bajar();
+int bloquearia_esperar_barrera();
+
 /*
  * Variable global que contiene las rutinas que realizan cada llamada
  */
-servicio tabla_servicios[NSERVICIOS]={	{sis_crear_proceso},
-					{sis_terminar_proceso},
-					{sis_escribir},
-					{sis_obtener_id},
-					{sis_dormir},
-					{sis_crearMutex},
-					{sis_abrirMutex},
-					{sis_lockMutex},
-					{sis_unlockMutex},
-					{sis_cerrarMutex}};
+servicio tabla_servicios[NSERVICIOS]={	{sis_crear_proceso, NULL},
+					{sis_terminar_proceso, bloquea_siempre},
+					{sis_escribir, bloquearia_escribir},
+					{sis_obtener_id, NULL},
+					{sis_dormir, bloquea_siempre},
+					{sis_crearMutex, bloquearia_crearMutex},
+					{sis_abrirMutex, NULL},
+					{sis_lockMutex, bloquearia_lockMutex},
+					{sis_unlockMutex, NULL},
+					{sis_cerrarMutex, NULL},
+					{sis_esperar_proceso, bloquea_siempre},
+					{sis_ejecutar, bloquea_siempre},
+					{sis_crear_hilo, NULL},
+					{sis_args_hilo, NULL},
+					{sis_crear_proceso_ext, NULL},
+					{sis_obtener_args, NULL},
+					{sis_llamsis_lote, bloquea_siempre},
+					{sis_obtener_tiempo, NULL},
+					{sis_registrar_anillos, NULL},
+					{sis_enviar_anillo, bloquearia_enviar_anillo},
+					{sis_estad_llamsis, NULL},
+					{sis_crear_proceso_esp, bloquea_siempre},
+					{sis_fijar_limites, NULL},
+					{sis_obtener_limites, NULL},
+					{sis_leer_klog, NULL},
+					{sis_leer_caracter, bloquearia_leer_term},
+					{sis_leer_linea, bloquearia_leer_linea},
+					{sis_leer, bloquearia_leer_term},
+					{sis_estad_terminal, NULL},
+					{sis_esperar_eventos, bloquearia_esperar_eventos},
+					{sis_trylockMutex, NULL},
+					{sis_lock_timeout, bloquearia_lock_timeout},
+					{sis_crear_rwlock, bloquearia_crearMutex},
+					{sis_abrir_rwlock, NULL},
+					{sis_lock_lectura, bloquearia_lock_lectura},
+					{sis_lock_escritura, bloquearia_lock_escritura},
+					{sis_unlock_rw, NULL},
+					{sis_crear_semaforo, bloquearia_crearMutex},
+					{sis_abrir_semaforo, NULL},
+					{sis_sem_bajar, bloquearia_sem_bajar},
+					{sis_sem_subir, NULL},
+					{sis_crear_condicion, bloquearia_crearMutex},
+					{sis_abrir_condicion, NULL},
+					{sis_cond_wait, bloquea_siempre},
+					{sis_cond_signal, NULL},
+					{sis_cond_broadcast, NULL},
+					{sis_crear_barrera, bloquearia_crearMutex},
+					{sis_abrir_barrera, NULL},
+					{sis_esperar_barrera, bloquearia_esperar_barrera},
+					{sis_estad_cerrojos, NULL},
+					{sis_fijar_politica_mutex, NULL}};
 
 #endif /* _KERNEL_H */
 
@@ -19,7 +19,7 @@
 #define _LLAMSIS_H
 
 /* Numero de llamadas disponibles */
-#define NSERVICIOS 10
+#define NSERVICIOS 51
 
 #define CREAR_PROCESO 0
 #define TERMINAR_PROCESO 1
@@ -31,5 +31,66 @@
 #define LOCK_MUTEX 7
 #define UNLOCK_MUTEX 8
 #define CERRAR_MUTEX 9
+#define ESPERAR_PROCESO 10
+#define EJECUTAR 11
+#define CREAR_HILO 12
+#define ARGS_HILO 13
+#define CREAR_PROCESO_EXT 14
+#define OBTENER_ARGS 15
+#define LLAMSIS_LOTE 16
+#define OBTENER_TIEMPO 17
+#define REGISTRAR_ANILLOS 18
+#define ENVIAR_ANILLO 19
+#define ESTAD_LLAMSIS 20
+#define CREAR_PROCESO_ESP 21
+#define FIJAR_LIMITES 22
+#define OBTENER_LIMITES 23
+#define LEER_KLOG 24
+#define LEER_CARACTER 25
+#define LEER_LINEA 26
+#define LEER 27
+#define ESTAD_TERMINAL 28
+#define ESPERAR_EVENTOS 29
+#define TRYLOCK_MUTEX 30
+#define LOCK_TIMEOUT 31
+#define CREAR_RWLOCK 32
+#define ABRIR_RWLOCK 33
+#define LOCK_LECTURA 34
+#define LOCK_ESCRITURA 35
+#define UNLOCK_RW 36
+#define CREAR_SEMAFORO 37
+#define ABRIR_SEMAFORO 38
+#define SEM_BAJAR 39
+#define SEM_SUBIR 40
+#define CREAR_CONDICION 41
+#define ABRIR_CONDICION 42
+#define COND_WAIT 43
+#define COND_SIGNAL 44
+#define COND_BROADCAST 45
+#define CREAR_BARRERA 46
+#define ABRIR_BARRERA 47
+#define ESPERAR_BARRERA 48
+#define ESTAD_CERROJOS 49
+#define FIJAR_POLITICA_MUTEX 50
+
+/*
+ * Nombres de los servicios en el orden de sus numeros, para mostrar las
+ * estadisticas (ver estad_llamsis). Al anadir una llamada se anade tambien
+ * aqui su nombre.
+ */
+#define NOMBRES_SERVICIOS {"crear_proceso", "terminar_proceso", \
+	"escribir", "obtener_id", "dormir", "crear_mutex", "abrir_mutex", \
+	"lock", "unlock", "cerrar_mutex", "esperar_proceso", "ejecutar", \
+	"crear_hilo", "args_hilo", "crear_proceso_ext", "obtener_args", \
+	"llamsis_lote", "obtener_tiempo", "registrar_anillos", \
+	"enviar_anillo", "estad_llamsis", "crear_proceso_esp", \
+	"fijar_limites", "obtener_limites", "leer_klog", "leer_caracter", \
+	"leer_linea", "leer", "estad_terminal", "esperar_eventos", \
+	"trylock", "lock_timeout", "crear_rwlock", "abrir_rwlock", \
+	"lock_lectura", "lock_escritura", "unlock_rw", "crear_semaforo", \
+	"abrir_semaforo", "sem_bajar", "sem_subir", "crear_condicion", \
+	"abrir_condicion", "cond_wait", "cond_signal", "cond_broadcast", \
+	"crear_barrera", "abrir_barrera", "esperar_barrera", \
+	"estad_cerrojos", "fijar_politica_mutex"}
 
 #endif /* _LLAMSIS_H */
@@ -15,6 +15,11 @@
 
 #include "kernel.h"	/* Contiene defs. usadas por este modulo */
 #include <string.h> // Para operaciones con strings
+#include <stdarg.h> // Para klog
+#include <stdio.h> // Para vsnprintf
+#include <stdlib.h> // Para malloc
+#include <limits.h> // Para INT_MAX
+#include <dlfcn.h> // Para buscar simbolos en las imagenes
 
 /*
  *
@@ -48,7 +53,7 @@ static int buscar_BCP_libre(){
 /*
  *
  * Funciones que facilitan el manejo de las listas de BCPs
- *	insertar_ultimo eliminar_primero eliminar_elem
+ *	insertar_ultimo insertar_primero eliminar_primero eliminar_elem
  *
  * NOTA: PRIMERO SE DEBE LLAMAR A eliminar Y LUEGO A insertar
  */
@@ -65,6 +70,51 @@ static void insertar_ultimo(lista_BCPs *lista, BCP * proc){
 	proc->siguiente=NULL;
 }
 
+/*
+ * Inserta un BCP al principio de la lista.
+ */
+static void insertar_primero(lista_BCPs *lista, BCP * proc){
+	if (lista->primero==NULL)
+		lista->ultimo= proc;
+	proc->siguiente=lista->primero;
+	lista->primero= proc;
+}
+
+/*
+ * Inserta un BCP en una lista ordenada por prioridad, detras de los que
+ * tienen la misma (FIFO entre iguales).
+ */
+static void insertar_por_prioridad(lista_BCPs *lista, BCP * proc){
+	BCP *paux;
+
+	if (lista->primero==NULL || lista->primero->prioridad < proc->prioridad){
+		insertar_primero(lista, proc);
+		return;
+	}
+	for (paux=lista->primero; paux->siguiente &&
+	     paux->siguiente->prioridad >= proc->prioridad; paux=paux->siguiente)
+		;
+	proc->siguiente=paux->siguiente;
+	paux->siguiente=proc;
+	if (lista->ultimo==paux)
+		lista->ultimo=proc;
+}
+
+/*
+ * Pasa todos los BCP de la lista origen al final de la lista destino de
+ * una vez, dejando vacia la de origen.
+ */
+static void empalmar_lista(lista_BCPs *destino, lista_BCPs *origen){
+	if (origen->primero==NULL)
+		return;
+	if (destino->primero==NULL)
+		destino->primero=origen->primero;
+	else
+		destino->ultimo->siguiente=origen->primero;
+	destino->ultimo=origen->ultimo;
+	origen->primero=origen->ultimo=NULL;
+}
+
 /*
  * Elimina el primer BCP de la lista.
  */
@@ -96,312 +146,2795 @@ static void eliminar_elem(lista_BCPs *lista, BCP * proc){
 
 /*
  *
- * Funciones relacionadas con la planificacion
- *	espera_int planificador
+ * Funciones relacionadas con el registro del nucleo
+ *	klog volcar_klog
+ *
  */
 
 /*
- * Espera a que se produzca una interrupcion
+ * Anade un mensaje al registro del nucleo precedido del instante (ms desde
+ * el arranque) y del nivel. Si no cabe, se sobrescriben los mensajes mas
+ * antiguos. Se usa a traves de las macros klog_depura, klog_info... de
+ * kernel.h, que no generan codigo para los niveles que no se compilan.
  */
-static void espera_int(){
-	int nivel;
-
-	//printk("-> NO HAY LISTOS. ESPERA INT\n");
+void klog(int nivel, const char *formato, ...){
+	char mensaje[TAM_MENSAJE_LOG];
+	va_list args;
+	int n, i;
+	int nivel_int;
+
+	n=snprintf(mensaje, TAM_MENSAJE_LOG, "[%6u] <%d> ",
+		(unsigned int)(leer_reloj_CMOS()-tiempo_arranque), nivel);
+	va_start(args, formato);
+	n+=vsnprintf(mensaje+n, TAM_MENSAJE_LOG-n, formato, args);
+	va_end(args);
+	if (n>=TAM_MENSAJE_LOG){
+		n=TAM_MENSAJE_LOG;
+		mensaje[n-1]='\n';	/* truncado */
+	}
 
-	/* Baja al m�nimo el nivel de interrupci�n mientras espera */
-	nivel=fijar_nivel_int(NIVEL_1);
-	halt();
-	fijar_nivel_int(nivel);
+	nivel_int=fijar_nivel_int(NIVEL_3);
+	for (i=0; i<n; i++)
+		buf_log[(log_escritos++) % TAM_BUF_LOG]=mensaje[i];
+	if (log_escritos-log_volcados > TAM_BUF_LOG){
+		log_perdidos+=log_escritos-log_volcados-TAM_BUF_LOG;
+		log_volcados=log_escritos-TAM_BUF_LOG;
+	}
+	fijar_nivel_int(nivel_int);
 }
 
 /*
- * Funci�n de planificacion que implementa un algoritmo FIFO.
+ * Escribe en pantalla los mensajes del registro del nucleo que aun no se
+ * han volcado. Se invoca cuando el procesador esta ocioso y antes de
+ * liberar una imagen, por si es la ultima y el S.O. termina.
  */
-static BCP * planificador(){
-	while (lista_listos.primero==NULL)
-		espera_int();		/* No hay nada que hacer */
-	return lista_listos.primero;
+static void volcar_klog(){
+	unsigned int inicio, n;
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	if (log_perdidos>0){
+		printk("-> KLOG: %u bytes perdidos\n", log_perdidos);
+		log_perdidos=0;
+	}
+	while (log_volcados!=log_escritos){
+		inicio=log_volcados % TAM_BUF_LOG;
+		n=log_escritos-log_volcados;
+		if (n > TAM_BUF_LOG-inicio)
+			n=TAM_BUF_LOG-inicio;	/* hasta el final del buffer */
+		escribir_ker(&(buf_log[inicio]), n);
+		log_volcados+=n;
+	}
+	fijar_nivel_int(nivel);
 }
 
 /*
  *
- * Funcion auxiliar que termina proceso actual liberando sus recursos.
- * Usada por llamada terminar_proceso y por rutinas que tratan excepciones
+ * Funciones relacionadas con la cola de salida
+ *	hueco_salida encolar_salida drenar_salida
  *
  */
-static void liberar_proceso(){
-	BCP * p_proc_anterior;
 
-	liberar_imagen(p_proc_actual->info_mem); /* liberar mapa */
+/*
+ * Devuelve los bytes libres en la cola de salida.
+ */
+static unsigned int hueco_salida(){
+	return TAM_COLA_SALIDA-(salida_encolados-salida_volcados);
+}
 
-	p_proc_actual->estado=TERMINADO;
-	eliminar_primero(&lista_listos); /* proc. fuera de listos */
+/*
+ * Copia en la cola de salida todo lo que quepa del texto. Devuelve el
+ * numero de bytes copiados. Se llama con las interrupciones inhibidas.
+ */
+static unsigned int encolar_salida(char *texto, unsigned int longi){
+	unsigned int libre=hueco_salida();
+	unsigned int i;
+
+	if (longi>libre)
+		longi=libre;
+	for (i=0; i<longi; i++)
+		cola_salida[(salida_encolados++) % TAM_COLA_SALIDA]=texto[i];
+	return longi;
+}
 
-	/* Realizar cambio de contexto */
-	p_proc_anterior=p_proc_actual;
-	p_proc_actual=planificador();
+/*
+ * Escribe en pantalla hasta max bytes de la cola de salida. Si la cola
+ * baja de la marca baja, despierta a los procesos que esperaban hueco.
+ */
+static void drenar_salida(unsigned int max){
+	unsigned int inicio, n;
+	BCP *p_proc;
+	int nivel;
 
-	printk("-> C.CONTEXTO POR FIN: de %d a %d\n",
-			p_proc_anterior->id, p_proc_actual->id);
+	nivel=fijar_nivel_int(NIVEL_3);
+	while ((salida_volcados!=salida_encolados) && (max>0)){
+		inicio=salida_volcados % TAM_COLA_SALIDA;
+		n=salida_encolados-salida_volcados;
+		if (n > TAM_COLA_SALIDA-inicio)
+			n=TAM_COLA_SALIDA-inicio;	/* hasta el final de la cola */
+		if (n > max)
+			n=max;
+		escribir_ker(&(cola_salida[inicio]), n);
+		salida_volcados+=n;
+		max-=n;
+	}
 
-	liberar_pila(p_proc_anterior->pila);
-	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
-        return; /* no deber�a llegar aqui */
+	if (salida_encolados-salida_volcados <= MARCA_BAJA_SALIDA)
+		while (lista_espera_salida.primero!=NULL){
+			p_proc=lista_espera_salida.primero;
+			eliminar_primero(&lista_espera_salida);
+			p_proc->estado=LISTO;
+			insertar_ultimo(&lista_listos, p_proc);
+		}
+	fijar_nivel_int(nivel);
 }
 
 /*
  *
- * Funciones relacionadas con el tratamiento de interrupciones
- *	excepciones: exc_arit exc_mem
- *	interrupciones de reloj: int_reloj
- *	interrupciones del terminal: int_terminal
- *	llamadas al sistemas: llam_sis
- *	interrupciones SW: int_sw
+ * Funciones relacionadas con los descriptores de mutex
+ *	iniciar_descriptores liberar_descriptores posicion_desc
+ *	reservar_desc fijar_desc liberar_desc num_lecturas lecturas_desc
  *
  */
 
 /*
- * Tratamiento de excepciones aritmeticas
+ * Deja sin descriptores el grupo de un proceso nuevo: sin bloques y con
+ * el mapa de bits vacio, salvo los bits de los descriptores que pasan de
+ * LIMITE_DESC_MUTEX y las palabras que no existen, que se dan por usados
+ * para que reservar_desc no tenga que mirar el limite.
  */
-static void exc_arit(){
-
-	if (!viene_de_modo_usuario())
-		panico("excepcion aritmetica cuando estaba dentro del kernel");
-
-
-	printk("-> EXCEPCION ARITMETICA EN PROC %d\n", p_proc_actual->id);
-	liberar_proceso();
+static void iniciar_descriptores(BCP *lider){
+	int i;
 
-        return; /* no deber�a llegar aqui */
+	for (i=0; i<PALABRAS_MAPA_DESC; i++)
+		lider->desc_ocupados[i]=0;
+	if (LIMITE_DESC_MUTEX%32)
+		lider->desc_ocupados[PALABRAS_MAPA_DESC-1]=
+			~0u << (LIMITE_DESC_MUTEX%32);
+	lider->desc_llenas=(PALABRAS_MAPA_DESC<32) ?
+		~0u << PALABRAS_MAPA_DESC : 0;
+	lider->num_bloques_desc=0;
+	lider->descriptores_abiertos=0;
+	lider->palabras.num_bloques=0;
+	lider->palabras.bloques=lider->palabras_bloque;
 }
 
 /*
- * Tratamiento de excepciones en el acceso a memoria
+ * Devuelve la memoria de los bloques de un proceso cuya entrada queda
+ * libre: los de sus lecturas y, si es lider, los de los descriptores.
  */
-static void exc_mem(){
-
-	if (!viene_de_modo_usuario())
-		panico("excepcion de memoria cuando estaba dentro del kernel");
-
-
-	printk("-> EXCEPCION DE MEMORIA EN PROC %d\n", p_proc_actual->id);
-	liberar_proceso();
+static void liberar_descriptores(BCP *p_proc){
+	int i;
 
-        return; /* no deber�a llegar aqui */
+	for (i=0; i<MAX_BLOQUES_DESC; i++){
+		free(p_proc->lecturas[i]);
+		p_proc->lecturas[i]=NULL;
+	}
+	if (p_proc->lider!=p_proc)
+		return;
+	for (i=0; i<p_proc->num_bloques_desc; i++){
+		free(p_proc->bloques_desc[i]);
+		p_proc->bloques_desc[i]=NULL;
+	}
+	p_proc->num_bloques_desc=0;
+	p_proc->palabras.num_bloques=0;
 }
 
 /*
- * Tratamiento de interrupciones de terminal
+ * Devuelve la posicion en la tabla de mutex del descriptor del grupo o -1
+ * si no esta abierto.
  */
-static void int_terminal(){
-	char car;
-
-	car = leer_puerto(DIR_TERMINAL);
-	printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
+static int posicion_desc(BCP *lider, unsigned int desc){
 
-        return;
+	if (desc>=lider->num_bloques_desc*DESC_POR_BLOQUE)
+		return -1;
+	return lider->bloques_desc[desc/DESC_POR_BLOQUE]->posicion[desc%DESC_POR_BLOQUE];
 }
 
 /*
- * Tratamiento de interrupciones de reloj
+ * Reserva el descriptor libre mas bajo del grupo y, si es el primero de
+ * su bloque, el bloque. Devuelve el descriptor o -1 si no queda ninguno o
+ * no hay memoria. Como se reserva siempre el mas bajo, los bloques
+ * reservados son siempre los primeros.
+ * Se llama con las interrupciones inhibidas.
  */
-static void int_reloj(){
+static int reservar_desc(BCP *lider){
+	bloque_desc *bloque;
+	int palabra, desc, i;
 
-	//printk("-> TRATANDO INT. DE RELOJ\n");
-	
-	//TRATAR PROCESOS DORMIDOS (SLEEP)
-	BCPptr aux = lista_dormidos.primero;
-	while(aux != NULL)
-	{
-		aux->segs_restantes -= 1;
-		BCPptr aux2 = aux->siguiente;
-		if(aux->segs_restantes == 0){
-			int nivel = fijar_nivel_int(NIVEL_3);
-			eliminar_elem(&(lista_dormidos), aux);
-			insertar_ultimo(&(lista_listos), aux);
-			fijar_nivel_int(nivel);
-		}
-		aux = aux2;
-	}
+	if (lider->desc_llenas==~0u)
+		return -1;
+	palabra=__builtin_ctz(~lider->desc_llenas);
+	desc=palabra*32+__builtin_ctz(~lider->desc_ocupados[palabra]);
 
-	//COMPROBAR SI EL PROC. HA ACABADO SU ROJADA (ROUND ROBIN)
-	p_proc_actual -> TICKS_por_rodaja--;
-	if(p_proc_actual-> TICKS_por_rodaja <= 0)
-	{
-		p_proc_a_expulsar = p_proc_actual;
-		activar_int_SW();
+	if (desc/DESC_POR_BLOQUE==lider->num_bloques_desc){
+		if ((bloque=malloc(sizeof(bloque_desc)))==NULL){
+			klog_aviso("Error: no hay memoria para descriptores\n");
+			return -1;
+		}
+		for (i=0; i<DESC_POR_BLOQUE; i++){
+			bloque->posicion[i]=-1;
+			bloque->palabra[i]=NULL;
+		}
+		lider->bloques_desc[lider->num_bloques_desc]=bloque;
+		lider->palabras_bloque[lider->num_bloques_desc]=bloque->palabra;
+		lider->palabras.num_bloques=++lider->num_bloques_desc;
 	}
-	
 
-    //return;
+	lider->desc_ocupados[palabra]|=1u << (desc%32);
+	if (lider->desc_ocupados[palabra]==~0u)
+		lider->desc_llenas|=1u << palabra;
+	lider->descriptores_abiertos++;
+	return desc;
 }
 
 /*
- * Tratamiento de llamadas al sistema
+ * Asocia un descriptor reservado a una entrada de la tabla de mutex y a
+ * su palabra (NULL si no es un mutex).
  */
-static void tratar_llamsis(){
-	int nserv, res;
+static void fijar_desc(BCP *lider, int desc, int pos, palabra_mutex *palabra){
+	bloque_desc *bloque=lider->bloques_desc[desc/DESC_POR_BLOQUE];
 
-	nserv=leer_registro(0);
-	if (nserv<NSERVICIOS)
-		res=(tabla_servicios[nserv].fservicio)();
-	else
-		res=-1;		/* servicio no existente */
-	escribir_registro(0,res);
-	return;
+	bloque->posicion[desc%DESC_POR_BLOQUE]=pos;
+	bloque->palabra[desc%DESC_POR_BLOQUE]=palabra;
 }
 
 /*
- * Tratamiento de interrupciuones software
+ * Deja libre un descriptor abierto del grupo. Su bloque se conserva.
+ * Se llama con las interrupciones inhibidas.
  */
-static void int_sw(){
-
-	printk("-> TRATANDO INT. SW\n");
-	
-	if (p_proc_a_expulsar == p_proc_actual)
-	{
-		BCP* proceso_A = p_proc_actual;
-		BCP* proceso_B;
-		int nivel = fijar_nivel_int(NIVEL_1);
+static void liberar_desc(BCP *lider, int desc){
 
-		eliminar_elem(&lista_listos, proceso_A);
-		insertar_ultimo(&lista_listos, proceso_A);
+	fijar_desc(lider, desc, -1, NULL);
+	lider->desc_ocupados[desc/32]&=~(1u << (desc%32));
+	lider->desc_llenas&=~(1u << (desc/32));
+	lider->descriptores_abiertos--;
+}
 
-		p_proc_actual=planificador();
-		proceso_B = p_proc_actual;
+/*
+ * Lecturas que tiene un proceso del rwlock de un descriptor de su grupo.
+ */
+static int num_lecturas(BCP *p_proc, unsigned int desc){
+	int *bloque=p_proc->lecturas[desc/DESC_POR_BLOQUE];
 
-		proceso_B->TICKS_por_rodaja = TICKS_POR_RODAJA;
+	return bloque ? bloque[desc%DESC_POR_BLOQUE] : 0;
+}
 
-		cambio_contexto(&(proceso_A->contexto_regs), &(proceso_B->contexto_regs));
+/*
+ * Devuelve el contador de lecturas de un proceso para un descriptor de su
+ * grupo, reservando su bloque si no lo tiene, o NULL si no hay memoria.
+ * Se llama con las interrupciones inhibidas.
+ */
+static int * lecturas_desc(BCP *p_proc, unsigned int desc){
+	int **bloque=&(p_proc->lecturas[desc/DESC_POR_BLOQUE]);
 
-		fijar_nivel_int(nivel);
+	if (*bloque==NULL){
+		if ((*bloque=malloc(DESC_POR_BLOQUE*sizeof(int)))==NULL){
+			klog_aviso("Error: no hay memoria para las lecturas\n");
+			return NULL;
+		}
+		memset(*bloque, 0, DESC_POR_BLOQUE*sizeof(int));
 	}
-	
-	return;
+	return &((*bloque)[desc%DESC_POR_BLOQUE]);
 }
 
 /*
  *
- * Funcion auxiliar que crea un proceso reservando sus recursos.
- * Usada por llamada crear_proceso.
- *
+ * Funciones relacionadas con la liberacion diferida de procesos
+ *	despertar_espera_BCP liberar_BCP_si_procede liberar_zombis
  */
-static int crear_tarea(char *prog){
-	void * imagen, *pc_inicial;
-	int error=0;
-	int proc;
-	BCP *p_proc;
 
-	proc=buscar_BCP_libre();
-	if (proc==-1)
-		return -1;	/* no hay entrada libre */
+/*
+ * Despierta al primer proceso que espera en crear_proceso_esp a que
+ * quede libre una entrada de la tabla de procesos. Este vuelve a buscarla
+ * y, si todavia no hay ninguna, se bloquea de nuevo el primero de la cola.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void despertar_espera_BCP(){
+	BCP *p_proc=lista_espera_BCP.primero;
+
+	if (p_proc==NULL)
+		return;
+	eliminar_primero(&lista_espera_BCP);
+	p_proc->estado=LISTO;
+	insertar_ultimo(&lista_listos, p_proc);
+}
 
-	/* A rellenar el BCP ... */
-	p_proc=&(tabla_procs[proc]);
+/*
+ * Deja libre la entrada de un proceso terminado cuando ya nadie la
+ * necesita: su pila se ha liberado, su padre no tiene que recoger el
+ * estado y, si es lider de un grupo de hilos, no le queda ningun miembro.
+ */
+static void liberar_BCP_si_procede(BCP *p_proc){
+
+	if ((p_proc->estado!=ZOMBI) || (p_proc->pila!=NULL) ||
+	    (p_proc->padre!=NULL))
+		return;
+	if ((p_proc->lider==p_proc) && (p_proc->miembros>0))
+		return;
+	liberar_descriptores(p_proc);
+	p_proc->estado=NO_USADA;
+	despertar_espera_BCP();
+}
 
-	/* crea la imagen de memoria leyendo ejecutable */
-	imagen=crear_imagen(prog, &pc_inicial);
-	if (imagen)
-	{
-		p_proc->info_mem=imagen;
-		p_proc->pila=crear_pila(TAM_PILA);
-		fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
-			pc_inicial,
-			&(p_proc->contexto_regs));
-		p_proc->id=proc;
-		p_proc->estado=LISTO;
-		p_proc->segs_restantes = 0;
-		p_proc->TICKS_por_rodaja = TICKS_POR_RODAJA;
+/*
+ * Libera en bloque la imagen y la pila de los procesos terminados que
+ * estan pendientes en la lista de zombis, dejando libre su entrada de la
+ * tabla de procesos. Se invoca cuando el procesador esta ocioso o cuando
+ * no quedan entradas libres en la tabla de procesos.
+ */
+static void liberar_zombis(){
+	BCP *p_proc;
+	int nivel;
 
-		// Para los mutex
-		for(int i = 0; i < NUM_MUT_PROC; i++)
-		{
-			p_proc->descriptores[i] = -1;
+	nivel=fijar_nivel_int(NIVEL_3);
+	while (lista_zombis.primero!=NULL){
+		p_proc=lista_zombis.primero;
+		eliminar_primero(&lista_zombis);
+
+		liberar_pila(p_proc->pila);
+		p_proc->pila=NULL;
+		liberar_BCP_si_procede(p_proc);
+
+		/* la imagen solo la libera el ultimo miembro de su grupo;
+		   si es la ultima imagen del sistema, el S.O. termina aqui */
+		if (p_proc->info_mem){
+			drenar_salida(TAM_COLA_SALIDA);
+			volcar_klog();
+			liberar_imagen(p_proc->info_mem);
 		}
-		p_proc->descriptores_abiertos = 0;
-
-		/* lo inserta al final de cola de listos */
-		insertar_ultimo(&lista_listos, p_proc);
-		error= 0;
 	}
-	else
-		error= -1; /* fallo al crear imagen */
+	fijar_nivel_int(nivel);
+}
 
-	return error;
+/*
+ * La biblioteca de usuario sabe asi que proceso la esta usando y que
+ * mutex tiene abiertos. Se llama con las interrupciones inhibidas.
+ */
+static void publicar_proc_usuario(BCP *p_proc){
+
+	if (p_proc->id_usuario)
+		*(p_proc->id_usuario)=p_proc->id;
+	/* con lockstat activo, lock y unlock siempre entran en el nucleo */
+	if (p_proc->palabras_usuario)
+		*(p_proc->palabras_usuario)=lockstat_activo ? NULL :
+			&(p_proc->lider->palabras);
 }
 
 /*
  *
- * Rutinas que llevan a cabo las llamadas al sistema
- *	sis_crear_proceso sis_escribir
- *
+ * Funciones relacionadas con la planificacion
+ *	espera_int planificador
  */
 
 /*
- * Tratamiento de llamada al sistema crear_proceso. Llama a la
- * funcion auxiliar crear_tarea sis_terminar_proceso
+ * Espera a que se produzca una interrupcion
  */
-int sis_crear_proceso(){
-	char *prog;
-	int res;
+static void espera_int(){
+	int nivel;
 
-	printk("-> PROC %d: CREAR PROCESO\n", p_proc_actual->id);
-	prog=(char *)leer_registro(1);
-	res=crear_tarea(prog);
-	return res;
+	//printk("-> NO HAY LISTOS. ESPERA INT\n");
+
+	/* Aprovecha el tiempo ocioso para vaciar la cola de salida, volcar
+	   el registro del nucleo y liberar los procesos terminados */
+	drenar_salida(TAM_COLA_SALIDA);
+	volcar_klog();
+	liberar_zombis();
+
+	/* Baja al m�nimo el nivel de interrupci�n mientras espera */
+	nivel=fijar_nivel_int(NIVEL_1);
+	halt();
+	fijar_nivel_int(nivel);
 }
 
 /*
- * Tratamiento de llamada al sistema escribir. Llama simplemente a la
- * funcion de apoyo escribir_ker
+ * Funci�n de planificacion que elige el proceso listo de mayor prioridad.
+ * A igual prioridad se elige el primero de la cola (FIFO), por lo que si
+ * todos tienen la prioridad por defecto se comporta como un FIFO.
  */
-int sis_escribir()
-{
-	char *texto;
-	unsigned int longi;
+static BCP * planificador(){
+	BCP *p_proc, *elegido;
 
-	texto=(char *)leer_registro(1);
-	longi=(unsigned int)leer_registro(2);
+	while (lista_listos.primero==NULL)
+		espera_int();		/* No hay nada que hacer */
 
-	escribir_ker(texto, longi);
-	return 0;
+	elegido=lista_listos.primero;
+	for (p_proc=elegido->siguiente; p_proc; p_proc=p_proc->siguiente)
+		if (p_proc->prioridad > elegido->prioridad)
+			elegido=p_proc;
+
+	publicar_proc_usuario(elegido);
+	return elegido;
 }
 
 /*
- * Tratamiento de llamada al sistema terminar_proceso. Llama a la
- * funcion auxiliar liberar_proceso
+ *
+ * Funciones relacionadas con el buffer del terminal
+ *	guardar_caracter sacar_caracter despertar_lector esperar_caracter
+ *
  */
-int sis_terminar_proceso(){
 
-	printk("-> FIN PROCESO %d\n", p_proc_actual->id);
+/*
+ * Guarda en el buffer del terminal un caracter recibido. Si el buffer
+ * esta lleno, lo cuenta como perdido y devuelve -1.
+ * Se llama con las interrupciones inhibidas.
+ */
+static int guardar_caracter(char car){
 
-	// Buscar mutex que hay que cerrar al terminar un proceso
-	for(int j = 0; j < NUM_MUT_PROC; j++)
-	{
-		// Comprobar que posiciones del array de descriptores tienen un mutex asignado
-		if(p_proc_actual->descriptores[j] != -1)
-		{
-			escribir_registro(1, j);
-			sis_cerrarMutex();
-		}
+	if (term_recibidos-term_leidos >= TAM_BUF_TERMINAL){
+		term_perdidos++;
+		return -1;
 	}
-	liberar_proceso();
-
-        return 0; /* no deber�a llegar aqui */
+	buf_term[(term_recibidos++) % TAM_BUF_TERMINAL]=car;
+	return 0;
 }
 
-int sis_obtener_id(){
+/*
+ * Saca el caracter mas antiguo del buffer del terminal, que no debe
+ * estar vacio. Se llama con las interrupciones inhibidas.
+ */
+static int sacar_caracter(){
 
-	return p_proc_actual->id;
+	return (unsigned char)buf_term[(term_leidos++) % TAM_BUF_TERMINAL];
 }
 
-int sis_dormir(){
+/*
+ * Despierta al primer proceso bloqueado leyendo del terminal. Solo a uno:
+ * un caracter nuevo no le sirve a mas de un lector.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void despertar_lector(){
+	BCP *p_proc;
 
-	//se lee el parametro de la llamada (segundos)
-	unsigned int segs = (unsigned int)leer_registro(1);
+	if (lista_espera_term.primero==NULL)
+		return;
+	p_proc=lista_espera_term.primero;
+	eliminar_primero(&lista_espera_term);
+	p_proc->estado=LISTO;
+	insertar_ultimo(&lista_listos, p_proc);
+}
 
-	//fijar nivel interrupcion
-	int nivel = fijar_nivel_int(NIVEL_3);
+/*
+ * Bloquea al proceso actual hasta que haya algun caracter en el buffer del
+ * terminal. Si al despertar otro proceso ya se lo ha llevado, vuelve a
+ * esperar el primero de la cola. Se llama con las interrupciones inhibidas.
+ */
+static void esperar_caracter(){
+	BCP *actual=p_proc_actual;
+	int reintento=0;
+
+	while (term_recibidos==term_leidos){
+		actual->estado=BLOQUEADO;
+		eliminar_elem(&lista_listos, actual);
+		if (reintento)
+			insertar_primero(&lista_espera_term, actual);
+		else
+			insertar_ultimo(&lista_espera_term, actual);
+		reintento=1;
+
+		p_proc_actual=planificador();
+		cambio_contexto(&(actual->contexto_regs), &(p_proc_actual->contexto_regs));
+	}
+}
+
+/*
+ *
+ * Funciones relacionadas con las estadisticas de los mutex (lockstat)
+ *	anotar_cambio_dueno anotar_espera
+ *
+ */
+
+/*
+ * Anota que un mutex pasa de su dueno actual (si lo tiene) al indicado (o
+ * queda libre si es NULL): el tiempo que lo ha tenido el primero, si se
+ * sabe cuando lo cogio, y una adquisicion del segundo.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void anotar_cambio_dueno(Mutex *mutex, BCP *nuevo){
+	unsigned long long ahora;
+	unsigned int ms;
+
+	if (!lockstat_activo || mutex->clase!=CLASE_MUTEX){
+		mutex->inicio_retencion=0;
+		return;
+	}
+	ahora=leer_reloj_CMOS();
+	if (MUTEX_DUENO(mutex->palabra.estado) && mutex->inicio_retencion){
+		ms=(unsigned int)(ahora-mutex->inicio_retencion);
+		mutex->estad.retencion_total+=ms;
+		if (ms>mutex->estad.retencion_max)
+			mutex->estad.retencion_max=ms;
+	}
+	mutex->inicio_retencion=nuevo ? ahora : 0;
+	if (nuevo)
+		mutex->estad.adquisiciones++;
+}
+
+/*
+ * Anota un lock que ha conseguido el mutex despues de esperar desde el
+ * instante indicado. Se llama con las interrupciones inhibidas.
+ */
+static void anotar_espera(Mutex *mutex, unsigned long long inicio){
+	unsigned int ms;
+
+	if (!lockstat_activo)
+		return;
+	ms=(unsigned int)(leer_reloj_CMOS()-inicio);
+	mutex->estad.contendidas++;
+	mutex->estad.espera_total+=ms;
+	if (ms>mutex->estad.espera_max)
+		mutex->estad.espera_max=ms;
+}
+
+/*
+ *
+ * Funciones relacionadas con la palabra de los mutex
+ *	dueno_mutex actualizar_esperas_mutex fijar_dueno_mutex
+ *	prioridad_heredada propagar_prioridad
+ *
+ */
+
+/*
+ * Devuelve el proceso que tiene bloqueado el mutex o NULL si esta libre.
+ */
+static BCP * dueno_mutex(Mutex *mutex){
+	int dueno=MUTEX_DUENO(mutex->palabra.estado);
+
+	return dueno ? &(tabla_procs[dueno-1]) : NULL;
+}
+
+/*
+ * Activa MUTEX_ESPERAS en la palabra de un mutex bloqueado si algo espera
+ * por el en el nucleo, y lo desactiva si no, para que el unlock de la
+ * biblioteca entre en el nucleo solo cuando haga falta.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void actualizar_esperas_mutex(Mutex *mutex){
+	int dueno=MUTEX_DUENO(mutex->palabra.estado);
+
+	if (dueno && (mutex->lista_espera.primero!=NULL ||
+	    mutex->lista_espera_async.primero!=NULL ||
+	    mutex->esperas_ev.primero!=NULL))
+		mutex->palabra.estado=dueno | MUTEX_ESPERAS;
+	else
+		mutex->palabra.estado=dueno;
+}
+
+/*
+ * Da el mutex al proceso indicado con un bloqueo, o lo deja libre si es
+ * NULL. Se llama con las interrupciones inhibidas.
+ */
+static void fijar_dueno_mutex(Mutex *mutex, BCP *p_proc){
+
+	anotar_cambio_dueno(mutex, p_proc);
+	mutex->palabra.estado=p_proc ? p_proc->id+1 : 0;
+	mutex->palabra.bloqueos=p_proc ? 1 : 0;
+	actualizar_esperas_mutex(mutex);
+}
+
+/*
+ * Calcula la prioridad efectiva de un proceso: la suya o, si es mayor, la
+ * del primer proceso que espera en lock por alguno de los mutex que tiene
+ * bloqueados (las listas de espera estan ordenadas por prioridad y esa
+ * prioridad ya incluye lo que hereda a su vez).
+ * Se llama con las interrupciones inhibidas.
+ */
+static int prioridad_heredada(BCP *p_proc){
+	int prioridad=p_proc->prioridad_base;
+	int posicion_mutex;
+	BCP *primero;
+
+	for (int j = 0; j < p_proc->lider->num_bloques_desc*DESC_POR_BLOQUE; j++){
+		posicion_mutex=posicion_desc(p_proc->lider, j);
+		if (posicion_mutex==-1 ||
+		    dueno_mutex(&(MUTEX_EN(posicion_mutex)))!=p_proc)
+			continue;
+		primero=MUTEX_EN(posicion_mutex).lista_espera.primero;
+		if (primero && primero->prioridad > prioridad)
+			prioridad=primero->prioridad;
+	}
+	return prioridad;
+}
+
+/*
+ * Recalcula la prioridad efectiva de un proceso cuando cambian los que
+ * esperan por sus mutex y, si cambia y el tambien espera por un mutex,
+ * lo recoloca en esa lista y sigue con el dueno de ese mutex, de modo
+ * que la herencia recorre las cadenas de mutex. El recorrido se corta a
+ * las MAX_PROC vueltas por si la cadena es un interbloqueo.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void propagar_prioridad(BCP *p_proc){
+	Mutex *mutex;
+	int prioridad;
+
+	for (int vueltas = 0; p_proc && vueltas < MAX_PROC; vueltas++){
+		prioridad=prioridad_heredada(p_proc);
+		if (prioridad==p_proc->prioridad)
+			return;
+		p_proc->prioridad=prioridad;
+
+		mutex=p_proc->mutex_espera;
+		if (mutex==NULL || p_proc->estado!=BLOQUEADO)
+			return;
+		eliminar_elem(&(mutex->lista_espera), p_proc);
+		insertar_por_prioridad(&(mutex->lista_espera), p_proc);
+		p_proc=dueno_mutex(mutex);
+	}
+}
+
+/*
+ *
+ * Funciones relacionadas con esperar_eventos
+ *	registrar_espera cancelar_esperas notificar_eventos eventos_listos
+ *
+ */
+
+/*
+ * Engancha un registro de espera del proceso actual a la lista de una
+ * fuente de eventos. Se llama con las interrupciones inhibidas.
+ */
+static void registrar_espera(espera_ev *esp, lista_esperas *lista){
+
+	esp->proc=p_proc_actual;
+	esp->lista=lista;
+	esp->anterior=NULL;
+	esp->siguiente=lista->primero;
+	if (lista->primero!=NULL)
+		lista->primero->anterior=esp;
+	lista->primero=esp;
+}
+
+/*
+ * Desengancha todos los registros de espera del proceso.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void cancelar_esperas(BCP *p_proc){
+	espera_ev *esp;
+	int i;
+
+	for (i=0; i<MAX_ESPERAS_EV; i++){
+		esp=&(p_proc->esperas_ev[i]);
+		if (esp->lista==NULL)
+			continue;
+		if (esp->anterior!=NULL)
+			esp->anterior->siguiente=esp->siguiente;
+		else
+			esp->lista->primero=esp->siguiente;
+		if (esp->siguiente!=NULL)
+			esp->siguiente->anterior=esp->anterior;
+		esp->lista=NULL;
+	}
+}
+
+/*
+ * Despierta a los procesos registrados en la lista de una fuente de
+ * eventos que ha podido quedar lista. Siguen registrados: al despertar
+ * comprueban que fuentes lo estan y cancelan sus registros.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void notificar_eventos(lista_esperas *lista){
+	espera_ev *esp;
+	BCP *p_proc;
+
+	for (esp=lista->primero; esp!=NULL; esp=esp->siguiente){
+		p_proc=esp->proc;
+		if (p_proc->estado!=BLOQUEADO)
+			continue;	/* ya lo desperto otra fuente */
+		eliminar_elem(&lista_espera_eventos, p_proc);
+		p_proc->estado=LISTO;
+		insertar_ultimo(&lista_listos, p_proc);
+	}
+}
+
+/* definida mas adelante, con los rwlock */
+static int lectura_bloquearia(Mutex *rw, BCP *p_proc, int desc);
+
+/*
+ * Devuelve que eventos del conjunto estan listos para el proceso actual.
+ * Un descriptor de mutex que ya no esta abierto se da por listo, para que
+ * la operacion que haga despues el proceso le devuelva el error. Uno de
+ * rwlock esta listo si una lectura no tendria que esperar, uno de
+ * semaforo si sem_bajar no tendria que esperar y uno de variable condicion
+ * o de barrera siempre, ya que no son fuentes de eventos.
+ * Se llama con las interrupciones inhibidas.
+ */
+static int eventos_listos(int conjunto){
+	int listos=0;
+	int i, posicion_mutex;
+	Mutex *mutex;
+
+	for (i=0; i<NUM_MUT_PROC; i++){
+		if (!(conjunto & EV_MUTEX(i)))
+			continue;
+		posicion_mutex=posicion_desc(p_proc_actual->lider, i);
+		if (posicion_mutex==-1){
+			listos|=EV_MUTEX(i);
+			continue;
+		}
+		mutex=&(MUTEX_EN(posicion_mutex));
+		if (mutex->clase==CLASE_RWLOCK){
+			if (!lectura_bloquearia(mutex, p_proc_actual, i))
+				listos|=EV_MUTEX(i);
+		}
+		else if (mutex->clase==CLASE_SEMAFORO){
+			if (mutex->valor>0)
+				listos|=EV_MUTEX(i);
+		}
+		else if (mutex->clase==CLASE_CONDICION || mutex->clase==CLASE_BARRERA)
+			listos|=EV_MUTEX(i);
+		else if ((dueno_mutex(mutex)==NULL) || (dueno_mutex(mutex)==p_proc_actual))
+			listos|=EV_MUTEX(i);
+	}
+	if ((conjunto & EV_TERMINAL) && (term_recibidos!=term_leidos))
+		listos|=EV_TERMINAL;
+	return listos;
+}
+
+/*
+ *
+ * Funciones relacionadas con la relacion padre-hijo
+ *	notificar_fin_hijo desvincular_hijos hijo_por_recoger
+ *
+ */
+
+/*
+ * Si el padre del proceso que termina esta bloqueado esperandole, le
+ * entrega directamente el estado de terminacion y lo despierta. En ese
+ * caso el hijo queda desvinculado y su BCP se podra reutilizar en cuanto
+ * se libere. Se llama con las interrupciones inhibidas.
+ */
+static void notificar_fin_hijo(BCP *hijo){
+	BCP *padre=hijo->padre;
+
+	if ((padre==NULL) || (padre->espera_hijo==NO_ESPERA))
+		return;
+	if ((padre->espera_hijo!=-1) && (padre->espera_hijo!=hijo->id))
+		return;
+
+	padre->hijo_recogido=hijo->id;
+	padre->estado_hijo=hijo->estado_fin;
+	padre->espera_hijo=NO_ESPERA;
+	hijo->padre=NULL;
+
+	padre->estado=LISTO;
+	eliminar_elem(&lista_espera_hijos, padre);
+	insertar_ultimo(&lista_listos, padre);
+}
+
+/*
+ * Los hijos del proceso que termina se quedan sin padre. Los que ya
+ * terminaron y fueron liberados solo conservaban el BCP para que el padre
+ * recogiera su estado, por lo que su entrada queda libre.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void desvincular_hijos(BCP *padre){
+	int i;
+
+	for (i=0; i<MAX_PROC; i++)
+		if (tabla_procs[i].padre==padre){
+			tabla_procs[i].padre=NULL;
+			liberar_BCP_si_procede(&(tabla_procs[i]));
+		}
+}
+
+/*
+ * Devuelve 1 si el proceso tiene algun hijo terminado cuyo estado no ha
+ * recogido todavia. Ese hijo conserva su entrada de la tabla de procesos
+ * hasta que el padre llame a esperar_proceso.
+ */
+static int hijo_por_recoger(BCP *padre){
+	int i;
+
+	for (i=0; i<MAX_PROC; i++)
+		if ((tabla_procs[i].padre==padre) &&
+		    (tabla_procs[i].estado==ZOMBI))
+			return 1;
+	return 0;
+}
+
+/*
+ *
+ * Funciones relacionadas con las operaciones asincronas
+ *	insertar_async eliminar_async reservar_pet publicar_fin
+ *	cancelar_async conceder_lock_async cancelar_lock_async iniciar_op_async
+ *
+ */
+
+/*
+ * Inserta una peticion al final de una lista de peticiones.
+ */
+static void insertar_async(lista_async *lista, pet_async *pet){
+	if (lista->primero==NULL)
+		lista->primero= pet;
+	else
+		lista->ultimo->siguiente=pet;
+	lista->ultimo= pet;
+	pet->siguiente=NULL;
+	pet->lista=lista;
+}
+
+/*
+ * Elimina una peticion de la lista en la que esta (si esta en alguna).
+ */
+static void eliminar_async(pet_async *pet){
+	lista_async *lista=pet->lista;
+	pet_async *paux;
+
+	if (lista==NULL)
+		return;
+	if (lista->primero==pet){
+		lista->primero=pet->siguiente;
+		if (lista->ultimo==pet)
+			lista->ultimo=NULL;
+	}
+	else {
+		for (paux=lista->primero; paux && (paux->siguiente!=pet);
+			paux=paux->siguiente);
+		if (paux) {
+			if (lista->ultimo==pet)
+				lista->ultimo=paux;
+			paux->siguiente=pet->siguiente;
+		}
+	}
+	pet->lista=NULL;
+}
+
+/*
+ * Busca una entrada libre en la tabla de peticiones asincronas.
+ */
+static pet_async * reservar_pet(){
+	int i;
+
+	for (i=0; i<MAX_PET_ASYNC; i++)
+		if (tabla_async[i].proc==NULL)
+			return &(tabla_async[i]);
+	return NULL;
+}
+
+/*
+ * Escribe la finalizacion de una peticion en el anillo de su proceso y
+ * libera la peticion. Si el proceso esta bloqueado en enviar_anillo y ya
+ * tiene las finalizaciones que esperaba, lo despierta. enviar_anillo
+ * garantiza que siempre hay hueco en el anillo de finalizacion.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void publicar_fin(pet_async *pet, long resultado){
+	BCP *p_proc=pet->proc;
+	anillo_fin *fin=p_proc->anillo_fin;
+
+	fin->entradas[fin->cola % TAM_ANILLO].dato=pet->dato;
+	fin->entradas[fin->cola % TAM_ANILLO].resultado=resultado;
+	fin->cola++;
+	p_proc->en_vuelo--;
+
+	eliminar_async(pet);
+	pet->proc=NULL;
+
+	if ((p_proc->espera_fin>0) &&
+	    (fin->cola - fin->cabeza >= p_proc->espera_fin)){
+		p_proc->espera_fin=0;
+		p_proc->estado=LISTO;
+		eliminar_elem(&lista_espera_anillo, p_proc);
+		insertar_ultimo(&lista_listos, p_proc);
+	}
+}
+
+/*
+ * Descarta sin publicar nada las peticiones pendientes de un proceso,
+ * que termina o cambia de imagen. Se llama con las interrupciones inhibidas.
+ */
+static void cancelar_async(BCP *p_proc){
+	int i;
+
+	for (i=0; i<MAX_PET_ASYNC; i++)
+		if (tabla_async[i].proc==p_proc){
+			eliminar_async(&(tabla_async[i]));
+			tabla_async[i].proc=NULL;
+		}
+	p_proc->en_vuelo=0;
+}
+
+/*
+ * Si hay algun OP_LOCK pendiente sobre el mutex, que esta libre, se lo
+ * concede al primero. Se llama con las interrupciones inhibidas.
+ */
+static void conceder_lock_async(int posicion_mutex){
+	Mutex *mutex=&(MUTEX_EN(posicion_mutex));
+	pet_async *pet=mutex->lista_espera_async.primero;
+
+	if (pet==NULL)
+		return;
+	eliminar_async(pet);
+	fijar_dueno_mutex(mutex, pet->proc);
+	publicar_fin(pet, 0);
+}
+
+/*
+ * Termina con error los OP_LOCK pendientes sobre un mutex que se destruye.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void cancelar_lock_async(int posicion_mutex){
+	Mutex *mutex=&(MUTEX_EN(posicion_mutex));
+
+	while (mutex->lista_espera_async.primero!=NULL)
+		publicar_fin(mutex->lista_espera_async.primero, -1);
+}
+
+/*
+ * Pone en marcha una operacion leida del anillo de envio del proceso
+ * actual. Las que no tienen que esperar terminan aqui mismo; el resto
+ * queda en la lista de lo que espera y termina en una interrupcion o
+ * en un unlock. Se llama con las interrupciones inhibidas.
+ */
+static void iniciar_op_async(pet_async *pet, peticion_anillo *peticion){
+	unsigned int mutex_id, n;
+	int posicion_mutex;
+	Mutex *mutex;
+
+	pet->proc=p_proc_actual;
+	pet->op=peticion->op;
+	pet->dato=peticion->dato;
+	pet->lista=NULL;
+	p_proc_actual->en_vuelo++;
+
+	switch (peticion->op){
+	case OP_ESCRIBIR:
+		/* si no cabe en la cola de salida, se vacia aqui mismo */
+		n=encolar_salida((char *)peticion->arg1,
+			(unsigned int)peticion->arg2);
+		while (n<(unsigned int)peticion->arg2){
+			drenar_salida(TAM_COLA_SALIDA);
+			n+=encolar_salida((char *)peticion->arg1+n,
+				(unsigned int)peticion->arg2-n);
+		}
+		publicar_fin(pet, 0);
+		break;
+
+	case OP_DORMIR:
+		pet->ticks_restantes=(unsigned int)peticion->arg1*TICK;
+		if (pet->ticks_restantes==0)
+			publicar_fin(pet, 0);
+		else
+			insertar_async(&lista_async_dormir, pet);
+		break;
+
+	case OP_LEER_CAR:
+		if (term_recibidos!=term_leidos)
+			publicar_fin(pet, sacar_caracter());
+		else
+			insertar_async(&lista_async_leer, pet);
+		break;
+
+	case OP_LOCK:
+		mutex_id=(unsigned int)peticion->arg1;
+		if ((posicion_mutex=posicion_desc(p_proc_actual->lider, mutex_id))==-1 ||
+		    MUTEX_EN(posicion_mutex).clase!=CLASE_MUTEX){
+			publicar_fin(pet, -1);
+			break;
+		}
+		mutex=&(MUTEX_EN(posicion_mutex));
+		if (dueno_mutex(mutex)==NULL){
+			fijar_dueno_mutex(mutex, p_proc_actual);
+			publicar_fin(pet, 0);
+		}
+		else if (dueno_mutex(mutex)==p_proc_actual){
+			if (mutex->palabra.tipo==NO_RECURSIVO)
+				publicar_fin(pet, -2);	/* interbloqueo */
+			else {
+				mutex->palabra.bloqueos++;
+				publicar_fin(pet, 0);
+			}
+		}
+		else {
+			pet->arg1=posicion_mutex;
+			insertar_async(&(mutex->lista_espera_async), pet);
+			actualizar_esperas_mutex(mutex);
+		}
+		break;
+
+	default:
+		publicar_fin(pet, -1);	/* operacion no existente */
+	}
+}
+
+/*
+ *
+ * Funciones relacionadas con la tabla de mutex
+ *	iniciar_tabla_mutex crecer_tabla_mutex hash_nombre buscar_mutex
+ *	reservar_mutex insertar_nombre destruir_mutex entrada_de
+ *
+ */
+
+/*
+ * Deja vacio el indice de nombres y la tabla sin bloques: las entradas se
+ * reservan al crear los mutex (ver crecer_tabla_mutex).
+ */
+static void iniciar_tabla_mutex(){
+	int i;
+
+	for (i=0; i<TAM_HASH_MUTEX; i++)
+		hash_mutex[i]=-1;
+	num_bloques_mutex=0;
+	primer_mutex_libre=-1;
+}
+
+/*
+ * Anade un bloque a la tabla de mutex y pone sus entradas, en orden, en
+ * la lista de libres, que debe estar vacia. Del ultimo bloque solo se usan
+ * las que no pasan de LIMITE_MUTEX. Devuelve -1 si ya se ha llegado al
+ * limite o no hay memoria. Se llama con las interrupciones inhibidas.
+ */
+static int crecer_tabla_mutex(){
+	int primera=num_bloques_mutex*MUTEX_POR_BLOQUE;
+	int pos;
+	Mutex *bloque;
+
+	if (num_bloques_mutex==MAX_BLOQUES_MUTEX)
+		return -1;
+	if ((bloque=malloc(MUTEX_POR_BLOQUE*sizeof(Mutex)))==NULL){
+		klog_aviso("Error: no hay memoria para la tabla de mutex\n");
+		return -1;
+	}
+	memset(bloque, 0, MUTEX_POR_BLOQUE*sizeof(Mutex));
+	bloques_mutex[num_bloques_mutex++]=bloque;
+
+	pos=primera+MUTEX_POR_BLOQUE;
+	if (pos>LIMITE_MUTEX)
+		pos=LIMITE_MUTEX;
+	while (--pos>=primera){
+		MUTEX_EN(pos).estado=LIBRE;
+		fijar_dueno_mutex(&(MUTEX_EN(pos)), NULL);
+		MUTEX_EN(pos).siguiente=primer_mutex_libre;
+		primer_mutex_libre=pos;
+	}
+	return 0;
+}
+
+/*
+ * Cubo de la tabla hash que corresponde a un nombre (FNV-1a).
+ */
+static unsigned int hash_nombre(const char *nombre){
+	unsigned int h=2166136261u;
+
+	while (*nombre)
+		h=(h ^ (unsigned char)*nombre++)*16777619u;
+	return h % TAM_HASH_MUTEX;
+}
+
+/*
+ * Devuelve la posicion del mutex con ese nombre o -1 si no existe.
+ * Se llama con las interrupciones inhibidas.
+ */
+static int buscar_mutex(const char *nombre){
+	int pos;
+
+	for (pos=hash_mutex[hash_nombre(nombre)]; pos!=-1;
+	     pos=MUTEX_EN(pos).siguiente)
+		if (strcmp(nombre, MUTEX_EN(pos).nombre)==0)
+			return pos;
+	return -1;
+}
+
+/*
+ * Saca una entrada de la lista de libres, haciendo crecer la tabla si no
+ * queda ninguna. Devuelve su posicion o -1 si la tabla ya tiene
+ * LIMITE_MUTEX entradas y estan todas ocupadas (o no hay memoria).
+ * Se llama con las interrupciones inhibidas.
+ */
+static int reservar_mutex(){
+	int pos;
+
+	if (primer_mutex_libre==-1 && crecer_tabla_mutex()==-1)
+		return -1;
+	pos=primer_mutex_libre;
+	primer_mutex_libre=MUTEX_EN(pos).siguiente;
+	return pos;
+}
+
+/*
+ * Anade al indice de nombres una entrada recien reservada, cuyo nombre
+ * ya esta copiado. Se llama con las interrupciones inhibidas.
+ */
+static void insertar_nombre(int pos){
+	unsigned int cubo=hash_nombre(MUTEX_EN(pos).nombre);
+
+	MUTEX_EN(pos).siguiente=hash_mutex[cubo];
+	hash_mutex[cubo]=pos;
+}
+
+/*
+ * Saca de las variables condicion a los que esperan en ellas tras soltar
+ * en cond_wait el mutex que se destruye. Pasan a listos sin el mutex, de
+ * modo que cond_wait devuelve -1 aunque la entrada se reutilice antes de
+ * que alguien haga cond_signal. Se llama con las interrupciones inhibidas.
+ */
+static void expulsar_de_condiciones(Mutex *mutex){
+	Mutex *cond;
+	BCP *p_proc, *sig;
+	int pos, i;
+
+	/* lo normal es que no haya ninguno: no se recorren las condiciones */
+	for (i=0; i<MAX_PROC; i++)
+		if ((tabla_procs[i].estado==BLOQUEADO) &&
+		    (tabla_procs[i].mutex_cond==mutex))
+			break;
+	if (i==MAX_PROC)
+		return;
+
+	for (pos=0; pos<num_bloques_mutex*MUTEX_POR_BLOQUE && pos<LIMITE_MUTEX;
+	     pos++){
+		cond=&(MUTEX_EN(pos));
+		if (cond->estado==LIBRE || cond->clase!=CLASE_CONDICION)
+			continue;
+		for (p_proc=cond->lista_espera.primero; p_proc; p_proc=sig){
+			sig=p_proc->siguiente;
+			if (p_proc->mutex_cond!=mutex)
+				continue;
+			eliminar_elem(&(cond->lista_espera), p_proc);
+			cond->num_procesos_esperando--;
+			p_proc->mutex_cond=NULL;
+			p_proc->concedido=0;
+			p_proc->estado=LISTO;
+			insertar_ultimo(&lista_listos, p_proc);
+		}
+	}
+}
+
+/*
+ * Destruye un mutex al cerrarse su ultimo descriptor: los que esperaban
+ * por el (hilos del grupo que lo cerro) fallan, igual que los que lo
+ * soltaron en cond_wait, su nombre sale del indice y la entrada vuelve a
+ * la lista de libres, despertando a un proceso que esperase una en
+ * crear_mutex. Se llama con las interrupciones inhibidas.
+ */
+static void destruir_mutex(int pos){
+	Mutex *mutex=&(MUTEX_EN(pos));
+	BCP *dueno=dueno_mutex(mutex);
+	int *p;
+	BCP *p_proc;
+
+	cancelar_lock_async(pos);
+	notificar_eventos(&(mutex->esperas_ev));
+	if (mutex->clase==CLASE_MUTEX)
+		expulsar_de_condiciones(mutex);
+	while (mutex->lista_espera.primero!=NULL){
+		p_proc=mutex->lista_espera.primero;
+		eliminar_primero(&(mutex->lista_espera));
+		p_proc->mutex_espera=NULL;
+		p_proc->estado=LISTO;
+		insertar_ultimo(&lista_listos, p_proc);
+	}
+
+	for (p=&(hash_mutex[hash_nombre(mutex->nombre)]); *p!=pos;
+	     p=&(MUTEX_EN(*p).siguiente))
+		;
+	*p=mutex->siguiente;
+	mutex->nombre[0]='\0';
+	mutex->estado=LIBRE;
+	fijar_dueno_mutex(mutex, NULL);
+	mutex->num_procesos_esperando=0;
+	mutex->clase=CLASE_MUTEX;
+	mutex->lectores=0;
+	mutex->siguiente=primer_mutex_libre;
+	primer_mutex_libre=pos;
+
+	/* un hilo del grupo que lo tuviera bloqueado pierde lo heredado */
+	if (dueno)
+		propagar_prioridad(dueno);
+
+	if (lista_bloqueados_mutex.primero!=NULL){
+		p_proc=lista_bloqueados_mutex.primero;
+		eliminar_primero(&lista_bloqueados_mutex);
+		p_proc->estado=LISTO;
+		insertar_ultimo(&lista_listos, p_proc);
+	}
+}
+
+/*
+ * Devuelve la entrada del descriptor indicado del proceso actual o NULL si
+ * el descriptor no es valido o es de otra clase.
+ */
+static Mutex * entrada_de(unsigned int desc, int clase){
+	int pos;
+
+	if ((pos=posicion_desc(p_proc_actual->lider, desc))==-1 ||
+	    MUTEX_EN(pos).clase!=clase)
+		return NULL;
+	return &(MUTEX_EN(pos));
+}
+
+/*
+ *
+ * Funciones relacionadas con los rwlock
+ *	lectura_bloquearia conceder_rwlock soltar_rwlock
+ *
+ */
+
+/*
+ * Indica si una lectura del rwlock por ese descriptor tendria que esperar:
+ * si hay un escritor dentro o, con PREF_ESCRITOR, esperando. No espera el
+ * que ya tiene una lectura (se interbloquearia con el escritor que espera
+ * a que la suelte) ni el que lo tiene para escribir (es un error).
+ */
+static int lectura_bloquearia(Mutex *rw, BCP *p_proc, int desc){
+	BCP *dueno=dueno_mutex(rw);
+
+	if (num_lecturas(p_proc, desc)>0 || dueno==p_proc)
+		return 0;
+	if (dueno!=NULL)
+		return 1;
+	return (rw->preferencia==PREF_ESCRITOR && rw->lista_espera.primero!=NULL);
+}
+
+/*
+ * Reparte un rwlock que puede haber quedado sin escritor ni lectores. Si
+ * lo acaba de soltar un escritor, o no espera ningun escritor, entran a
+ * la vez todos los lectores que esperan; si no, el primer escritor (el de
+ * mas prioridad). Se llama con las interrupciones inhibidas.
+ */
+static void conceder_rwlock(Mutex *rw, int solto_escritor){
+	BCP *p_proc;
+
+	if (dueno_mutex(rw)!=NULL || rw->lectores>0)
+		return;
+	if (rw->lista_lectores.primero!=NULL &&
+	    (solto_escritor || rw->lista_espera.primero==NULL)){
+		while ((p_proc=rw->lista_lectores.primero)!=NULL){
+			eliminar_primero(&(rw->lista_lectores));
+			(*lecturas_desc(p_proc, p_proc->lectura_espera))++;
+			rw->lectores++;
+			p_proc->estado=LISTO;
+			insertar_ultimo(&lista_listos, p_proc);
+		}
+	}
+	else if ((p_proc=rw->lista_espera.primero)!=NULL){
+		eliminar_primero(&(rw->lista_espera));
+		p_proc->mutex_espera=NULL;
+		p_proc->estado=LISTO;
+		insertar_ultimo(&lista_listos, p_proc);
+		fijar_dueno_mutex(rw, p_proc);
+		rw->num_procesos_esperando--;
+		propagar_prioridad(p_proc);
+	}
+	if (dueno_mutex(rw)==NULL)
+		notificar_eventos(&(rw->esperas_ev));
+}
+
+/*
+ * Suelta lo que tiene el grupo del proceso actual de un rwlock cuyo
+ * descriptor se cierra: los procesos del grupo que esperaban por el
+ * fallan y pierden sus lecturas y, si uno de ellos es el escritor, la
+ * escritura. Se llama con las interrupciones inhibidas.
+ */
+static void soltar_rwlock(Mutex *rw, int desc){
+	BCP *lider=p_proc_actual->lider;
+	BCP *dueno=dueno_mutex(rw);
+	BCP *p_proc, *sig;
+	int solto_escritor=0;
+
+	for (p_proc=rw->lista_lectores.primero; p_proc; p_proc=sig){
+		sig=p_proc->siguiente;
+		if (p_proc->lider==lider){
+			eliminar_elem(&(rw->lista_lectores), p_proc);
+			p_proc->estado=LISTO;
+			insertar_ultimo(&lista_listos, p_proc);
+		}
+	}
+	for (p_proc=rw->lista_espera.primero; p_proc; p_proc=sig){
+		sig=p_proc->siguiente;
+		if (p_proc->lider==lider){
+			eliminar_elem(&(rw->lista_espera), p_proc);
+			p_proc->mutex_espera=NULL;
+			p_proc->estado=LISTO;
+			insertar_ultimo(&lista_listos, p_proc);
+			rw->num_procesos_esperando--;
+		}
+	}
+	for (int i = 0; i < MAX_PROC; i++){
+		p_proc=&(tabla_procs[i]);
+		if (p_proc->lider==lider && num_lecturas(p_proc, desc)>0){
+			rw->lectores-=num_lecturas(p_proc, desc);
+			*lecturas_desc(p_proc, desc)=0;
+		}
+	}
+	if (dueno!=NULL && dueno->lider==lider){
+		fijar_dueno_mutex(rw, NULL);
+		solto_escritor=1;
+	}
+	conceder_rwlock(rw, solto_escritor);
+
+	/* el escritor ya no hereda la prioridad de los del grupo */
+	if (dueno!=NULL)
+		propagar_prioridad(dueno);
+}
+
+/*
+ *
+ * Funcion auxiliar que termina proceso actual liberando sus recursos.
+ * Usada por llamada terminar_proceso y por rutinas que tratan excepciones
+ *
+ * La imagen y la pila no se liberan aqui: el proceso pasa a la lista de
+ * zombis y se liberan en bloque mas tarde (ver liberar_zombis), de modo
+ * que el siguiente proceso empieza a ejecutar sin esperar a esa tarea.
+ *
+ */
+static void liberar_proceso(int estado_fin){
+	BCP * p_proc_anterior;
+	BCP * lider;
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	p_proc_actual->estado=ZOMBI;
+	p_proc_actual->estado_fin=estado_fin;
+	eliminar_elem(&lista_listos, p_proc_actual); /* proc. fuera de listos */
+	insertar_ultimo(&lista_zombis, p_proc_actual);
+	cancelar_async(p_proc_actual);
+
+	/* la imagen compartida la libera el ultimo miembro del grupo */
+	lider=p_proc_actual->lider;
+	lider->miembros--;
+	if (lider->miembros>0)
+		p_proc_actual->info_mem=NULL;
+	else if (lider!=p_proc_actual)
+		liberar_BCP_si_procede(lider);
+
+	desvincular_hijos(p_proc_actual);
+	notificar_fin_hijo(p_proc_actual);
+
+	/* quien espera una entrada libre la busca liberando los zombis */
+	despertar_espera_BCP();
+	fijar_nivel_int(nivel);
+
+	/* Realizar cambio de contexto */
+	p_proc_anterior=p_proc_actual;
+	p_proc_actual=planificador();
+
+	klog_depura("-> C.CONTEXTO POR FIN: de %d a %d\n",
+			p_proc_anterior->id, p_proc_actual->id);
+
+	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
+        return; /* no deber�a llegar aqui */
+}
+
+/*
+ *
+ * Funciones relacionadas con el tratamiento de interrupciones
+ *	excepciones: exc_arit exc_mem
+ *	interrupciones de reloj: int_reloj
+ *	interrupciones del terminal: int_terminal
+ *	llamadas al sistemas: llam_sis
+ *	interrupciones SW: int_sw
+ *
+ */
+
+/*
+ * Tratamiento de excepciones aritmeticas
+ */
+static void exc_arit(){
+
+	if (!viene_de_modo_usuario())
+		panico("excepcion aritmetica cuando estaba dentro del kernel");
+
+
+	klog_error("-> EXCEPCION ARITMETICA EN PROC %d\n", p_proc_actual->id);
+	liberar_proceso(FIN_EXCEPCION);
+
+        return; /* no deber�a llegar aqui */
+}
+
+/*
+ * Tratamiento de excepciones en el acceso a memoria
+ */
+static void exc_mem(){
+
+	if (!viene_de_modo_usuario())
+		panico("excepcion de memoria cuando estaba dentro del kernel");
+
+
+	klog_error("-> EXCEPCION DE MEMORIA EN PROC %d\n", p_proc_actual->id);
+	liberar_proceso(FIN_EXCEPCION);
+
+        return; /* no deber�a llegar aqui */
+}
+
+/*
+ * Tratamiento de interrupciones de terminal
+ */
+static void int_terminal(){
+	static int desbordado=0;	/* ya se ha avisado de la perdida */
+	char car;
+
+	car = leer_puerto(DIR_TERMINAL);
+	klog_depura("-> TRATANDO INT. DE TERMINAL %c\n", car);
+
+	if (guardar_caracter(car)<0){
+		/* un aviso por racha de caracteres perdidos */
+		if (!desbordado)
+			klog_aviso("-> BUFFER DE TERMINAL LLENO: se pierden caracteres\n");
+		desbordado=1;
+		return;
+	}
+	desbordado=0;
+
+	/* es para la primera OP_LEER_CAR pendiente o para un lector bloqueado */
+	if (lista_async_leer.primero!=NULL)
+		publicar_fin(lista_async_leer.primero, sacar_caracter());
+	else {
+		despertar_lector();
+		notificar_eventos(&esperas_ev_term);
+	}
+
+        return;
+}
+
+/*
+ * Tratamiento de interrupciones de reloj
+ */
+static void int_reloj(){
+
+	//printk("-> TRATANDO INT. DE RELOJ\n");
+	
+	//TRATAR PROCESOS DORMIDOS (SLEEP)
+	BCPptr aux = lista_dormidos.primero;
+	while(aux != NULL)
+	{
+		aux->segs_restantes -= 1;
+		BCPptr aux2 = aux->siguiente;
+		if(aux->segs_restantes == 0){
+			int nivel = fijar_nivel_int(NIVEL_3);
+			eliminar_elem(&(lista_dormidos), aux);
+			insertar_ultimo(&(lista_listos), aux);
+			fijar_nivel_int(nivel);
+		}
+		aux = aux2;
+	}
+
+	//TRATAR OPERACIONES OP_DORMIR PENDIENTES
+	pet_async *pet = lista_async_dormir.primero;
+	while(pet != NULL)
+	{
+		pet_async *pet2 = pet->siguiente;
+		if(--pet->ticks_restantes == 0)
+			publicar_fin(pet, 0);
+		pet = pet2;
+	}
+
+	//VACIAR PARTE DE LA COLA DE SALIDA AUNQUE EL PROCESADOR NO QUEDE OCIOSO
+	drenar_salida(SALIDA_POR_TICK);
+
+	//TRATAR PROCESOS BLOQUEADOS CON PLAZO (ver bloquear_con_plazo)
+	for(int i = 0; i < MAX_PROC; i++)
+	{
+		BCPptr p = &(tabla_procs[i]);
+		if(p->estado != BLOQUEADO || p->lista_plazo == NULL || p->ticks_plazo <= 0)
+			continue;
+		if(--p->ticks_plazo == 0)
+		{
+			eliminar_elem(p->lista_plazo, p);
+			p->plazo_vencido = 1;
+			p->estado = LISTO;
+			insertar_ultimo(&(lista_listos), p);
+		}
+	}
+
+	//CONTAR EL TICK AL PROCESO SI ESTA EJECUTANDO (NO SI EL PROCESADOR ESTA OCIOSO)
+	if(p_proc_actual->estado == LISTO)
+	{
+		p_proc_actual->ticks_cpu++;
+		if(p_proc_actual->limites.max_ticks > 0 &&
+		   p_proc_actual->ticks_cpu > p_proc_actual->limites.max_ticks &&
+		   p_proc_actual->fin_pendiente == 0)
+		{
+			//SE TERMINA EN int_sw, CUANDO VUELVA A MODO USUARIO
+			p_proc_actual->fin_pendiente = FIN_LIMITE_CPU;
+			activar_int_SW();
+		}
+	}
+
+	//COMPROBAR SI EL PROC. HA ACABADO SU ROJADA (ROUND ROBIN)
+	p_proc_actual -> TICKS_por_rodaja--;
+	if(p_proc_actual-> TICKS_por_rodaja <= 0)
+	{
+		p_proc_a_expulsar = p_proc_actual;
+		activar_int_SW();
+	}
+	
+
+    //return;
+}
+
+/*
+ * Anota en las estadisticas el resultado y la latencia de una llamada
+ */
+static void anotar_fin_llamada(estad_servicio *estad, int res, unsigned int lat){
+	int cubo=0;
+
+	while ((lat>>cubo) && (cubo<NUM_CUBOS_LAT-1))
+		cubo++;
+
+	if (res<0)
+		estad->errores++;
+	estad->lat_total+=lat;
+	if (lat>estad->lat_max)
+		estad->lat_max=lat;
+	estad->hist[cubo]++;
+}
+
+/*
+ * Ejecuta el servicio indicado, que debe existir, anotandolo en las
+ * estadisticas. Usada por tratar_llamsis y por llamsis_lote para cada
+ * llamada del lote.
+ */
+static int ejecutar_servicio(int nserv){
+	int res;
+	int proc;
+	unsigned long long int inicio;
+	unsigned int lat;
+
+	/* el proceso actual puede cambiar si la llamada bloquea */
+	proc=p_proc_actual-tabla_procs;
+	estad_total[nserv].llamadas++;
+	estad_proc[proc][nserv].llamadas++;
+	inicio=leer_reloj_CMOS();
+
+	res=(tabla_servicios[nserv].fservicio)();
+
+	lat=(unsigned int)(leer_reloj_CMOS()-inicio);
+	anotar_fin_llamada(&(estad_total[nserv]), res, lat);
+	anotar_fin_llamada(&(estad_proc[proc][nserv]), res, lat);
+	return res;
+}
+
+/*
+ * Tratamiento de llamadas al sistema
+ */
+static void tratar_llamsis(){
+	int nserv, res;
+
+	nserv=leer_registro(0);
+	if ((nserv>=0) && (nserv<NSERVICIOS))
+		res=ejecutar_servicio(nserv);
+	else
+		res=-1;		/* servicio no existente */
+	escribir_registro(0,res);
+	return;
+}
+
+/* definida mas adelante, junto a terminar_proceso */
+static void terminar_por_limite(int motivo);
+
+/*
+ * Tratamiento de interrupciuones software
+ */
+static void int_sw(){
+
+	klog_depura("-> TRATANDO INT. SW\n");
+
+	// TERMINAR EL PROCESO SI HA SUPERADO SU LIMITE DE UCP
+	if (p_proc_actual->fin_pendiente != 0)
+		terminar_por_limite(p_proc_actual->fin_pendiente);
+	
+	if (p_proc_a_expulsar == p_proc_actual)
+	{
+		BCP* proceso_A = p_proc_actual;
+		BCP* proceso_B;
+		int nivel = fijar_nivel_int(NIVEL_1);
+
+		eliminar_elem(&lista_listos, proceso_A);
+		insertar_ultimo(&lista_listos, proceso_A);
+
+		p_proc_actual=planificador();
+		proceso_B = p_proc_actual;
+
+		proceso_B->TICKS_por_rodaja = proceso_B->rodaja;
+
+		cambio_contexto(&(proceso_A->contexto_regs), &(proceso_B->contexto_regs));
+
+		fijar_nivel_int(nivel);
+	}
+	
+	return;
+}
+
+/*
+ *
+ * Funcion auxiliar que rellena los campos comunes del BCP de un proceso
+ * o hilo nuevo. Usada por crear_tarea y crear_hilo.
+ *
+ */
+static void iniciar_BCP(BCP *p_proc, int proc, int prioridad, int rodaja){
+	p_proc->id=proc;
+	p_proc->estado=LISTO;
+	p_proc->segs_restantes = 0;
+	p_proc->prioridad = prioridad;
+	p_proc->prioridad_base = prioridad;
+	p_proc->mutex_espera = NULL;
+	p_proc->mutex_cond = NULL;
+	p_proc->rodaja = rodaja;
+	p_proc->TICKS_por_rodaja = rodaja;
+
+	// Para esperar_proceso
+	p_proc->padre = p_proc_actual;
+	p_proc->estado_fin = 0;
+	p_proc->espera_hijo = NO_ESPERA;
+
+	// Para las operaciones asincronas
+	p_proc->anillo_env = NULL;
+	p_proc->anillo_fin = NULL;
+	p_proc->en_vuelo = 0;
+	p_proc->espera_fin = 0;
+
+	p_proc->lista_plazo = NULL;
+	p_proc->ticks_plazo = 0;
+	memset(p_proc->esperas_ev, 0, sizeof(p_proc->esperas_ev));
+
+	// Hereda los limites del proceso que lo crea
+	if (p_proc_actual)
+		p_proc->limites = p_proc_actual->limites;
+	else
+		memset(&(p_proc->limites), 0, sizeof(p_proc->limites));
+	p_proc->ticks_cpu = 0;
+	p_proc->fin_pendiente = 0;
+
+	// Las estadisticas de la entrada empiezan de cero
+	memset(estad_proc[proc], 0, sizeof(estad_proc[proc]));
+}
+
+/*
+ *
+ * Funcion auxiliar que busca una entrada libre en la tabla de procesos,
+ * liberando los procesos terminados pendientes si no queda ninguna.
+ * Usada por crear_tarea y crear_hilo.
+ *
+ */
+static int reservar_BCP(){
+	int proc;
+
+	proc=buscar_BCP_libre();
+	if (proc==-1){
+		/* recupera las entradas de los procesos ya terminados */
+		liberar_zombis();
+		proc=buscar_BCP_libre();
+	}
+	return proc;
+}
+
+/*
+ *
+ * Funcion auxiliar que bloquea al proceso actual, que ya se ha insertado
+ * en la lista indicada. Si ticks es mayor que 0, int_reloj lo saca de la
+ * lista y lo despierta cuando pasen aunque nadie lo haya despertado antes;
+ * en ticks_plazo queda lo que le sobraba. Devuelve 1 si vencio el plazo.
+ * Se llama con las interrupciones inhibidas.
+ *
+ */
+static int bloquear_con_plazo(lista_BCPs *lista, int ticks){
+	BCP *actual=p_proc_actual;
+
+	actual->estado=BLOQUEADO;
+	actual->ticks_plazo=ticks;
+	actual->lista_plazo=(ticks>0) ? lista : NULL;
+	actual->plazo_vencido=0;
+
+	p_proc_actual=planificador();
+	cambio_contexto(&(actual->contexto_regs), &(p_proc_actual->contexto_regs));
+
+	actual->lista_plazo=NULL;
+	return actual->plazo_vencido;
+}
+
+/*
+ *
+ * Funcion auxiliar que espera a que haya una entrada libre en la tabla de
+ * procesos durante segs segundos como mucho (sin limite si es negativo).
+ * Devuelve 0 si la hay, -1 si segs es 0, -2 si vence el plazo y -3 si ya
+ * hay MAX_ESPERA_BCP procesos esperando. Si el proceso tiene hijos
+ * terminados sin recoger devuelve -4 en lugar de esperar: sus entradas
+ * solo las libera el mismo con esperar_proceso, por lo que se bloquearia
+ * para siempre si son ellos los que llenan la tabla. Usada por
+ * crear_proceso_esp.
+ *
+ */
+static int esperar_BCP_libre(int segs){
+	int ticks=(segs>0) ? segs*TICK : 0;
+	int primera=1;
+	int vencido;
+	int nivel;
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	while (reservar_BCP()==-1){
+		if (hijo_por_recoger(p_proc_actual)){
+			fijar_nivel_int(nivel);
+			return -4;	/* que recoja antes a sus hijos */
+		}
+		if (segs==0){
+			fijar_nivel_int(nivel);
+			return -1;
+		}
+		if (primera && (num_espera_BCP>=MAX_ESPERA_BCP)){
+			fijar_nivel_int(nivel);
+			return -3;	/* cola de admision llena */
+		}
+
+		/* si ya estaba esperando no pierde su turno */
+		eliminar_elem(&lista_listos, p_proc_actual);
+		if (primera)
+			insertar_ultimo(&lista_espera_BCP, p_proc_actual);
+		else
+			insertar_primero(&lista_espera_BCP, p_proc_actual);
+		num_espera_BCP++;
+		vencido=bloquear_con_plazo(&lista_espera_BCP, ticks);
+		num_espera_BCP--;
+		primera=0;
+
+		if (vencido){
+			fijar_nivel_int(nivel);
+			return -2;
+		}
+		if (ticks>0)
+			ticks=p_proc_actual->ticks_plazo;
+	}
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+/*
+ *
+ * Funcion auxiliar que obtiene de la imagen la direccion de una variable
+ * de la biblioteca de usuario llamando a la funcion que la devuelve
+ * (FUNC_ID_USUARIO o FUNC_PALABRAS_USUARIO). Devuelve NULL si el programa
+ * no la tiene. Usada por crear_tarea y ejecutar.
+ *
+ */
+static void * buscar_var_usuario(void *imagen, char *nombre_func){
+	void *(*funcion)();
+
+	funcion=(void *(*)())dlsym(imagen, nombre_func);
+	if (funcion==NULL)
+		return NULL;
+	return funcion();
+}
+
+/*
+ *
+ * Funcion auxiliar que copia los argumentos del proceso en la parte alta
+ * de su pila: primero el vector de punteros (terminado en NULL) y a
+ * continuacion las cadenas. Devuelve el numero de bytes reservados o -1
+ * si no caben en la pila. Usada por crear_tarea.
+ *
+ */
+static int copiar_args(BCP *p_proc, int argc, char **argv){
+	int i, tam;
+	char **vector;
+	char *cadena;
+
+	if ((argc<=0) || (argv==NULL)){
+		p_proc->argc=0;
+		p_proc->argv=NULL;
+		return 0;
+	}
+
+	tam=(argc+1)*sizeof(char *);
+	for (i=0; i<argc; i++)
+		tam+=strlen(argv[i])+1;
+	tam=(tam+15) & ~15;	/* la cima de la pila queda alineada */
+	if (tam > p_proc->tam_pila/4)
+		return -1;
+
+	vector=(char **)((char *)p_proc->pila + p_proc->tam_pila - tam);
+	cadena=(char *)(vector+argc+1);
+	for (i=0; i<argc; i++){
+		strcpy(cadena, argv[i]);
+		vector[i]=cadena;
+		cadena+=strlen(argv[i])+1;
+	}
+	vector[argc]=NULL;
+
+	p_proc->argc=argc;
+	p_proc->argv=vector;
+	return tam;
+}
+
+/*
+ *
+ * Funcion auxiliar que crea un proceso reservando sus recursos.
+ * Usada por llamadas crear_proceso y crear_proceso_ext. Si atrib es
+ * NULL, o alguno de sus campos vale 0, se usan los valores por defecto.
+ *
+ */
+static int crear_tarea(char *prog, atrib_proceso *atrib){
+	void * imagen, *pc_inicial;
+	int error=0;
+	int proc;
+	BCP *p_proc;
+	int tam_pila=TAM_PILA;
+	int prioridad=PRIO_DEFECTO;
+	int rodaja=TICKS_POR_RODAJA;
+	int tam_args;
+
+	if (atrib){
+		if (atrib->tam_pila)
+			tam_pila=atrib->tam_pila;
+		if (atrib->prioridad)
+			prioridad=atrib->prioridad;
+		if (atrib->rodaja)
+			rodaja=atrib->rodaja;
+		if ((tam_pila<TAM_PILA_MIN) || (rodaja<0) ||
+		    (prioridad<PRIO_MIN) || (prioridad>PRIO_MAX))
+			return -1;	/* atributos no validos */
+	}
+
+	proc=reservar_BCP();
+	if (proc==-1)
+		return -1;	/* no hay entrada libre */
+
+	/* A rellenar el BCP ... */
+	p_proc=&(tabla_procs[proc]);
+
+	/* crea la imagen de memoria leyendo ejecutable */
+	imagen=crear_imagen(prog, &pc_inicial);
+	if (imagen)
+	{
+		p_proc->info_mem=imagen;
+		p_proc->id_usuario=buscar_var_usuario(imagen, FUNC_ID_USUARIO);
+		p_proc->palabras_usuario=buscar_var_usuario(imagen,
+			FUNC_PALABRAS_USUARIO);
+		p_proc->tam_pila=tam_pila;
+		p_proc->pila=crear_pila(tam_pila);
+
+		/* los argumentos ocupan la cima de la pila */
+		tam_args=copiar_args(p_proc, atrib ? atrib->argc : 0,
+			atrib ? atrib->argv : NULL);
+		if (tam_args<0){
+			liberar_pila(p_proc->pila);
+			liberar_imagen(imagen);
+			return -1;	/* los argumentos no caben */
+		}
+
+		fijar_contexto_ini(p_proc->info_mem, p_proc->pila,
+			tam_pila-tam_args,
+			pc_inicial,
+			&(p_proc->contexto_regs));
+		iniciar_BCP(p_proc, proc, prioridad, rodaja);
+
+		// Es el lider de su propio grupo
+		p_proc->lider = p_proc;
+		p_proc->miembros = 1;
+
+		// Para los mutex
+		iniciar_descriptores(p_proc);
+
+		/* lo inserta al final de cola de listos */
+		insertar_ultimo(&lista_listos, p_proc);
+		error= proc;	/* devuelve el identificador del nuevo proceso */
+	}
+	else
+		error= -1; /* fallo al crear imagen */
+
+	return error;
+}
+
+/*
+ *
+ * Funcion auxiliar que crea un hilo del proceso actual. El hilo tiene su
+ * propia pila y su propio contexto, pero comparte la imagen, los mutex
+ * abiertos y el grupo del proceso que lo crea, por lo que no se llama a
+ * crear_imagen. Usada por llamada crear_hilo.
+ *
+ */
+static int crear_hilo(void *pc_inicial, void *funcion, void *arg){
+	int proc;
+	BCP *p_proc;
+	BCP *lider=p_proc_actual->lider;
+
+	proc=reservar_BCP();
+	if (proc==-1)
+		return -1;	/* no hay entrada libre */
+
+	p_proc=&(tabla_procs[proc]);
+	p_proc->info_mem=p_proc_actual->info_mem;
+	p_proc->id_usuario=p_proc_actual->id_usuario;
+	p_proc->palabras_usuario=p_proc_actual->palabras_usuario;
+	p_proc->tam_pila=TAM_PILA;
+	p_proc->pila=crear_pila(TAM_PILA);
+	fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
+		pc_inicial,
+		&(p_proc->contexto_regs));
+	iniciar_BCP(p_proc, proc, p_proc_actual->prioridad_base,
+		p_proc_actual->rodaja);
+	p_proc->argc = 0;
+	p_proc->argv = NULL;
+
+	// Se une al grupo del proceso que lo crea
+	p_proc->lider = lider;
+	lider->miembros++;
+	p_proc->func_hilo = funcion;
+	p_proc->arg_hilo = arg;
+
+	/* lo inserta al final de cola de listos */
+	insertar_ultimo(&lista_listos, p_proc);
+	return proc;
+}
+
+/*
+ * Funcion auxiliar que cierra todos los mutex que tiene abiertos el
+ * proceso actual. Usada por terminar_proceso y por ejecutar.
+ */
+static void cerrar_descriptores_mutex(){
+
+	// Buscar mutex que hay que cerrar
+	for(int j = 0; j < p_proc_actual->lider->num_bloques_desc*DESC_POR_BLOQUE; j++)
+	{
+		// Comprobar que posiciones del array de descriptores tienen un mutex asignado
+		if(posicion_desc(p_proc_actual->lider, j) != -1)
+		{
+			escribir_registro(1, j);
+			sis_cerrarMutex();
+		}
+	}
+}
+
+/*
+ * Funcion auxiliar que desbloquea los mutex que tiene bloqueados el
+ * proceso actual sin cerrarlos. Usada cuando termina un hilo cuyo grupo
+ * sigue usando los descriptores abiertos.
+ */
+static void soltar_mutex_hilo(){
+	int posicion_mutex;
+
+	for(int j = 0; j < p_proc_actual->lider->num_bloques_desc*DESC_POR_BLOQUE; j++)
+	{
+		posicion_mutex = posicion_desc(p_proc_actual->lider, j);
+		if(posicion_mutex == -1)
+			continue;
+		escribir_registro(1, j);
+		if(MUTEX_EN(posicion_mutex).clase == CLASE_RWLOCK)
+		{
+			while(dueno_mutex(&(MUTEX_EN(posicion_mutex))) == p_proc_actual ||
+			      num_lecturas(p_proc_actual, j) > 0)
+				sis_unlock_rw();
+			continue;
+		}
+		while(dueno_mutex(&(MUTEX_EN(posicion_mutex))) == p_proc_actual)
+			sis_unlockMutex();
+	}
+}
+
+/*
+ * Funcion auxiliar que termina el proceso actual soltando sus mutex.
+ * Usada por terminar_proceso y cuando se supera un limite.
+ */
+static void terminar_actual(int estado_fin){
+
+	if (p_proc_actual->lider->miembros==1)
+		cerrar_descriptores_mutex();
+	else
+		soltar_mutex_hilo();	/* la tabla sigue en uso por el grupo */
+	liberar_proceso(estado_fin);
+}
+
+/*
+ * Funcion auxiliar que termina el proceso actual porque ha superado uno
+ * de sus limites. El motivo queda como estado de terminacion.
+ */
+static void terminar_por_limite(int motivo){
+
+	klog_aviso("-> PROC %d SUPERA SU LIMITE (%d)\n", p_proc_actual->id, motivo);
+	terminar_actual(motivo);
+}
+
+/*
+ * Funcion auxiliar que comprueba los limites del proceso actual antes de
+ * crear un proceso con los atributos indicados: cuenta los hijos que aun
+ * no ha recogido, terminen o no, ya que ocupan una entrada de la tabla.
+ * Si se supera algun limite, el proceso actual termina.
+ */
+static void comprobar_limites_crear(atrib_proceso *atrib){
+	limites_proceso *lim=&(p_proc_actual->limites);
+	int hijos=0;
+	int i;
+
+	if (lim->max_hijos>0){
+		for (i=0; i<MAX_PROC; i++)
+			if ((tabla_procs[i].padre==p_proc_actual) &&
+			    (tabla_procs[i].estado!=NO_USADA))
+				hijos++;
+		if (hijos>=lim->max_hijos)
+			terminar_por_limite(FIN_LIMITE_HIJOS);
+	}
+	if ((lim->max_pila>0) &&
+	    ((atrib && atrib->tam_pila) ? atrib->tam_pila : TAM_PILA) > lim->max_pila)
+		terminar_por_limite(FIN_LIMITE_PILA);
+}
+
+/*
+ * Funcion auxiliar que comprueba el limite de descriptores de mutex
+ * abiertos antes de abrir uno nuevo. Si se supera, el proceso termina.
+ */
+static void comprobar_limite_mutex(){
+	int max=p_proc_actual->limites.max_mutex;
+
+	if ((max>0) && (p_proc_actual->lider->descriptores_abiertos>=max))
+		terminar_por_limite(FIN_LIMITE_MUTEX);
+}
+
+/*
+ *
+ * Rutinas que llevan a cabo las llamadas al sistema
+ *	sis_crear_proceso sis_escribir
+ *
+ */
+
+/*
+ * Tratamiento de llamada al sistema crear_proceso. Llama a la
+ * funcion auxiliar crear_tarea sis_terminar_proceso
+ */
+int sis_crear_proceso(){
+	char *prog;
+	int res;
+
+	klog_info("-> PROC %d: CREAR PROCESO\n", p_proc_actual->id);
+	prog=(char *)leer_registro(1);
+	comprobar_limites_crear(NULL);
+	res=crear_tarea(prog, NULL);
+	return res;
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_proceso_ext. Igual que
+ * crear_proceso pero con tamano de pila, prioridad, rodaja y argumentos
+ * propios del nuevo proceso.
+ */
+int sis_crear_proceso_ext(){
+	char *prog;
+	atrib_proceso *atrib;
+	int res;
+
+	klog_info("-> PROC %d: CREAR PROCESO EXT\n", p_proc_actual->id);
+	prog=(char *)leer_registro(1);
+	atrib=(atrib_proceso *)leer_registro(2);
+	comprobar_limites_crear(atrib);
+	res=crear_tarea(prog, atrib);
+	return res;
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_proceso_esp. Igual que
+ * crear_proceso_ext (atrib puede ser NULL) pero, si la tabla de procesos
+ * esta llena, espera a que quede una entrada libre durante segs segundos
+ * como mucho (sin limite si es negativo) en lugar de fallar. Devuelve -2
+ * si vence el plazo, -3 si la cola de espera esta llena y -4 si antes
+ * tiene que recoger con esperar_proceso algun hijo terminado.
+ */
+int sis_crear_proceso_esp(){
+	char *prog;
+	atrib_proceso *atrib;
+	int segs;
+	int res;
+
+	klog_info("-> PROC %d: CREAR PROCESO ESP\n", p_proc_actual->id);
+	prog=(char *)leer_registro(1);
+	atrib=(atrib_proceso *)leer_registro(2);
+	segs=(int)leer_registro(3);
+	comprobar_limites_crear(atrib);
+
+	res=esperar_BCP_libre(segs);
+	if (res<0)
+		return res;
+	res=crear_tarea(prog, atrib);
+	return res;
+}
+
+/*
+ * Tratamiento de llamada al sistema obtener_args. Devuelve el numero de
+ * argumentos del proceso y el vector con ellos, que esta en su pila.
+ */
+int sis_obtener_args(){
+	int *argc;
+	char ***argv;
+
+	argc=(int *)leer_registro(1);
+	argv=(char ***)leer_registro(2);
+	if (argc)
+		*argc=p_proc_actual->argc;
+	if (argv)
+		*argv=p_proc_actual->argv;
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema escribir. Copia el texto en la cola
+ * de salida y vuelve sin esperar a que se escriba en pantalla. Si no cabe,
+ * se bloquea hasta que drenar_salida deje hueco. Un texto que cabe en la
+ * cola se copia entero de una vez, para que no se mezcle con otras salidas.
+ */
+int sis_escribir()
+{
+	char *texto;
+	unsigned int longi, n;
+	int nivel;
+
+	texto=(char *)leer_registro(1);
+	longi=(unsigned int)leer_registro(2);
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	while (longi>0){
+		if ((longi>TAM_COLA_SALIDA) || (longi<=hueco_salida())){
+			n=encolar_salida(texto, longi);
+			texto+=n;
+			longi-=n;
+		}
+		if (longi>0){
+			/* cola llena: espera a que baje de la marca baja */
+			BCP *actual=p_proc_actual;
+			actual->estado=BLOQUEADO;
+			eliminar_elem(&lista_listos, actual);
+			insertar_ultimo(&lista_espera_salida, actual);
+
+			p_proc_actual=planificador();
+			cambio_contexto(&(actual->contexto_regs), &(p_proc_actual->contexto_regs));
+		}
+	}
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema terminar_proceso. Llama a la
+ * funcion auxiliar terminar_actual con el estado de terminacion recibido
+ */
+int sis_terminar_proceso(){
+	int estado_fin;
+
+	estado_fin=(int)leer_registro(1);
+	klog_info("-> FIN PROCESO %d\n", p_proc_actual->id);
+
+	terminar_actual(estado_fin);
+
+        return 0; /* no deber�a llegar aqui */
+}
+
+/*
+ * Tratamiento de llamada al sistema fijar_limites. Cambia los limites de
+ * recursos del proceso actual. Solo se pueden reducir: falla si se quita
+ * un limite o se aumenta.
+ */
+int sis_fijar_limites(){
+	limites_proceso *nuevos;
+	int *actual, *nuevo;
+	int i;
+
+	nuevos=(limites_proceso *)leer_registro(1);
+	actual=(int *)&(p_proc_actual->limites);
+	nuevo=(int *)nuevos;
+	for (i=0; i<sizeof(limites_proceso)/sizeof(int); i++)
+		if ((nuevo[i]<0) ||
+		    ((actual[i]>0) && ((nuevo[i]==0) || (nuevo[i]>actual[i]))))
+			return -1;
+
+	p_proc_actual->limites=*nuevos;
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema obtener_limites. Devuelve los limites
+ * del proceso actual y los ticks de UCP que lleva consumidos.
+ */
+int sis_obtener_limites(){
+	limites_proceso *limites;
+
+	limites=(limites_proceso *)leer_registro(1);
+	if (limites)
+		*limites=p_proc_actual->limites;
+	return p_proc_actual->ticks_cpu;
+}
+
+/*
+ * Tratamiento de llamada al sistema ejecutar. Sustituye la imagen del
+ * proceso actual por la del programa indicado, manteniendo su BCP, su
+ * identificador y su pila. Si el segundo parametro es distinto de 0 se
+ * conservan los mutex abiertos; si no, se cierran como al terminar.
+ * Solo vuelve si no se ha podido cargar el programa.
+ */
+int sis_ejecutar(){
+	char *prog;
+	int conservar_mutex;
+	void *imagen, *pc_inicial;
+	int nivel;
+
+	prog=(char *)leer_registro(1);
+	conservar_mutex=(int)leer_registro(2);
+	klog_info("-> PROC %d: EJECUTAR %s\n", p_proc_actual->id, prog);
+
+	/* la imagen no se puede cambiar mientras la usen otros hilos */
+	if (p_proc_actual->lider->miembros>1)
+		return -1;
+
+	/* se carga antes de liberar la imagen actual, que contiene prog */
+	imagen=crear_imagen(prog, &pc_inicial);
+	if (!imagen)
+		return -1;	/* fallo al crear imagen: sigue con la actual */
+
+	if (!conservar_mutex)
+		cerrar_descriptores_mutex();
+
+	nivel=fijar_nivel_int(NIVEL_3);
+	/* los anillos estaban en la imagen que se libera */
+	cancelar_async(p_proc_actual);
+	p_proc_actual->anillo_env=NULL;
+	p_proc_actual->anillo_fin=NULL;
+	liberar_imagen(p_proc_actual->info_mem);
+	p_proc_actual->info_mem=imagen;
+	p_proc_actual->id_usuario=buscar_var_usuario(imagen, FUNC_ID_USUARIO);
+	p_proc_actual->palabras_usuario=buscar_var_usuario(imagen,
+		FUNC_PALABRAS_USUARIO);
+	publicar_proc_usuario(p_proc_actual);
+
+	/* reinicia el contexto sobre la misma pila, que ya no se usa */
+	p_proc_actual->argc=0;
+	p_proc_actual->argv=NULL;
+	fijar_contexto_ini(p_proc_actual->info_mem, p_proc_actual->pila,
+		p_proc_actual->tam_pila, pc_inicial,
+		&(p_proc_actual->contexto_regs));
+	fijar_nivel_int(nivel);
+
+	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
+	return 0; /* no deberia llegar aqui */
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_hilo. Recibe el punto de
+ * entrada de la biblioteca que arranca los hilos, y la funcion y el
+ * argumento que este debe usar. Llama a la funcion auxiliar crear_hilo
+ */
+int sis_crear_hilo(){
+	void *pc_inicial, *funcion, *arg;
+	int res;
+
+	klog_info("-> PROC %d: CREAR HILO\n", p_proc_actual->id);
+	pc_inicial=(void *)leer_registro(1);
+	funcion=(void *)leer_registro(2);
+	arg=(void *)leer_registro(3);
+	res=crear_hilo(pc_inicial, funcion, arg);
+	return res;
+}
+
+/*
+ * Tratamiento de llamada al sistema args_hilo. La usa el punto de entrada
+ * de los hilos para obtener la funcion que debe ejecutar y su argumento.
+ */
+int sis_args_hilo(){
+	void **funcion, **arg;
+
+	funcion=(void **)leer_registro(1);
+	arg=(void **)leer_registro(2);
+	if (p_proc_actual->lider==p_proc_actual)
+		return -1;	/* no es un hilo */
+
+	*funcion=p_proc_actual->func_hilo;
+	*arg=p_proc_actual->arg_hilo;
+	return 0;
+}
+
+int sis_obtener_id(){
+
+	return p_proc_actual->id;
+}
+
+/*
+ * Tratamiento de llamada al sistema obtener_tiempo. Devuelve los
+ * milisegundos transcurridos desde el arranque del sistema.
+ */
+int sis_obtener_tiempo(){
+
+	return (int)(leer_reloj_CMOS() - tiempo_arranque);
+}
+
+/*
+ * Tratamiento de llamada al sistema estad_llamsis. Copia en el vector
+ * recibido (hasta n entradas, una por servicio) las estadisticas del
+ * proceso indicado, o las totales si proc es -1, y las pone a cero si
+ * reiniciar es distinto de 0. Devuelve el numero de entradas copiadas o
+ * -1 si proc no es valido.
+ */
+int sis_estad_llamsis(){
+	int proc = (int)leer_registro(1);
+	estad_servicio *v = (estad_servicio *)leer_registro(2);
+	int n = (int)leer_registro(3);
+	int reiniciar = (int)leer_registro(4);
+	estad_servicio *estad;
+	int nivel;
+
+	if (proc == -1)
+		estad = estad_total;
+	else if (proc >= 0 && proc < MAX_PROC)
+		estad = estad_proc[proc];
+	else
+		return -1;
+	if (n > NSERVICIOS)
+		n = NSERVICIOS;
+	if (n < 0)
+		n = 0;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	if (v != NULL)
+		memcpy(v, estad, n*sizeof(estad_servicio));
+	if (reiniciar)
+		memset(estad, 0, NSERVICIOS*sizeof(estad_servicio));
+	fijar_nivel_int(nivel);
+	return n;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer_klog. Copia en buf (como dmesg)
+ * los ultimos n bytes como mucho que hay en el registro del nucleo, del
+ * mas antiguo al mas reciente. Devuelve el numero de bytes copiados.
+ */
+int sis_leer_klog(){
+	char *buf = (char *)leer_registro(1);
+	int n = (int)leer_registro(2);
+	unsigned int desde, inicio, tam;
+	int copiados = 0;
+	int nivel;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	if (n > TAM_BUF_LOG)
+		n = TAM_BUF_LOG;
+	if (n > log_escritos)
+		n = log_escritos;
+	if (n < 0)
+		n = 0;
+
+	desde = log_escritos - n;
+	while (copiados < n)
+	{
+		inicio = desde % TAM_BUF_LOG;
+		tam = n - copiados;
+		if (tam > TAM_BUF_LOG - inicio)
+			tam = TAM_BUF_LOG - inicio;
+		memcpy(buf + copiados, &(buf_log[inicio]), tam);
+		copiados += tam;
+		desde += tam;
+	}
+	fijar_nivel_int(nivel);
+	return copiados;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer_caracter. Devuelve el siguiente
+ * caracter del terminal, bloqueando al proceso si no ha llegado ninguno.
+ */
+int sis_leer_caracter(){
+	int car;
+	int nivel;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	esperar_caracter();
+	car = sacar_caracter();
+	fijar_nivel_int(nivel);
+	return car;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer. Espera a que haya al menos un
+ * caracter en el terminal y copia en buf todos los disponibles, hasta n.
+ * Devuelve el numero de caracteres copiados (-1 si n es negativo).
+ */
+int sis_leer(){
+	char *buf = (char *)leer_registro(1);
+	int n = (int)leer_registro(2);
+	int copiados = 0;
+	int nivel;
+
+	if (n < 0)
+		return -1;
+	if (n == 0)
+		return 0;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	esperar_caracter();
+	while (copiados < n && term_recibidos != term_leidos)
+		buf[copiados++] = sacar_caracter();
+	fijar_nivel_int(nivel);
+	return copiados;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer_linea. Copia en buf los caracteres
+ * del terminal hasta el fin de linea (incluido) o hasta n-1, bloqueando
+ * al proceso las veces que haga falta, y termina buf con un nulo.
+ * Devuelve el numero de caracteres copiados (-1 si n no es positivo).
+ */
+int sis_leer_linea(){
+	char *buf = (char *)leer_registro(1);
+	int n = (int)leer_registro(2);
+	int copiados = 0;
+	int car = 0;
+	int nivel;
+
+	if (n <= 0)
+		return -1;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	while (copiados < n - 1 && car != '\n')
+	{
+		esperar_caracter();
+		car = sacar_caracter();
+		buf[copiados++] = car;
+	}
+	buf[copiados] = '\0';
+	fijar_nivel_int(nivel);
+	return copiados;
+}
+
+/*
+ * Tratamiento de llamada al sistema estad_terminal. Copia en la direccion
+ * recibida (si no es nula) las estadisticas del terminal y devuelve los
+ * caracteres que se han perdido por estar lleno el buffer.
+ */
+int sis_estad_terminal(){
+	estad_term *estad = (estad_term *)leer_registro(1);
+	int nivel;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	if (estad != NULL)
+	{
+		estad->recibidos = term_recibidos;
+		estad->leidos = term_leidos;
+		estad->perdidos = term_perdidos;
+		estad->pendientes = term_recibidos - term_leidos;
+	}
+	fijar_nivel_int(nivel);
+	return term_perdidos;
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_eventos. Espera a que este
+ * listo alguno de los eventos del conjunto (EV_MUTEX(desc) y EV_TERMINAL)
+ * durante timeout ms como mucho (sin limite si es negativo, sin esperar
+ * si es 0). No consume nada: el proceso debe hacer despues el lock o la
+ * lectura. Devuelve el conjunto de eventos listos (0 si vence el plazo)
+ * o -1 si el conjunto no es valido.
+ */
+int sis_esperar_eventos(){
+	int conjunto = (int)leer_registro(1);
+	int timeout = (int)leer_registro(2);
+	long long ticks_ms = ((long long)timeout*TICK + 999)/1000;
+	int ticks = (timeout <= 0) ? 0 : (ticks_ms > INT_MAX) ? INT_MAX : (int)ticks_ms;
+	int posicion_mutex;
+	int listos, vencido = 0;
+	int nivel;
+
+	if (conjunto & ~(EV_TERMINAL | (EV_TERMINAL - 1)))
+		return -1;
+	if (conjunto == 0 && timeout < 0)
+		return -1;	/* no le despertaria nada */
+	for (int i = 0; i < NUM_MUT_PROC; i++)
+		if ((conjunto & EV_MUTEX(i)) &&
+		    posicion_desc(p_proc_actual->lider, i) == -1)
+			return -1;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	listos = eventos_listos(conjunto);
+	if (listos == 0 && timeout != 0)
+	{
+		for (int i = 0; i < NUM_MUT_PROC; i++)
+			if (conjunto & EV_MUTEX(i))
+			{
+				posicion_mutex = posicion_desc(p_proc_actual->lider, i);
+				registrar_espera(&(p_proc_actual->esperas_ev[i]),
+					&(MUTEX_EN(posicion_mutex).esperas_ev));
+				actualizar_esperas_mutex(&(MUTEX_EN(posicion_mutex)));
+			}
+		if (conjunto & EV_TERMINAL)
+			registrar_espera(&(p_proc_actual->esperas_ev[NUM_MUT_PROC]),
+				&esperas_ev_term);
+
+		/* puede despertar sin que haya nada listo (otro se adelanto) */
+		while (listos == 0 && !vencido)
+		{
+			eliminar_elem(&lista_listos, p_proc_actual);
+			insertar_ultimo(&lista_espera_eventos, p_proc_actual);
+			vencido = bloquear_con_plazo(&lista_espera_eventos, ticks);
+			if (ticks > 0)
+				ticks = p_proc_actual->ticks_plazo;
+			listos = eventos_listos(conjunto);
+		}
+		cancelar_esperas(p_proc_actual);
+	}
+	fijar_nivel_int(nivel);
+	return listos;
+}
+
+/*
+ * Tratamiento de llamada al sistema llamsis_lote. Ejecuta en orden las
+ * llamadas de un vector de op_lote con una sola entrada en el nucleo,
+ * dejando el resultado de cada una en su entrada. Se detiene en la primera
+ * que falla (su resultado queda escrito) o en la primera que bloquearia al
+ * proceso (que no se ejecuta). Devuelve el numero de llamadas completadas
+ * con exito. Cada llamada del lote cuenta en las estadisticas de su
+ * servicio, ademas de la del propio llamsis_lote.
+ */
+int sis_llamsis_lote(){
+	op_lote *ops;
+	int n, i, j;
+	int res;
+	servicio *serv;
+
+	ops=(op_lote *)leer_registro(1);
+	n=(int)leer_registro(2);
+
+	for (i=0; i<n; i++){
+		if ((ops[i].servicio<0) || (ops[i].servicio>=NSERVICIOS))
+		{
+			ops[i].resultado=-1;	/* servicio no existente */
+			break;
+		}
+		serv=&(tabla_servicios[ops[i].servicio]);
+
+		for (j=0; j<NARGS_LOTE; j++)
+			escribir_registro(j+1, ops[i].args[j]);
+
+		if (serv->bloquearia && (serv->bloquearia)())
+			break;
+
+		res=ejecutar_servicio(ops[i].servicio);
+		ops[i].resultado=res;
+		if (res<0)
+			break;
+	}
+	return i;
+}
+
+/*
+ * Tratamiento de llamada al sistema registrar_anillos. Fija los anillos
+ * de envio y de finalizacion del proceso (NULL los quita). No se pueden
+ * cambiar mientras haya operaciones sin terminar.
+ */
+int sis_registrar_anillos(){
+	anillo_envio *envio;
+	anillo_fin *fin;
+
+	envio=(anillo_envio *)leer_registro(1);
+	fin=(anillo_fin *)leer_registro(2);
+	if (p_proc_actual->en_vuelo>0)
+		return -1;
+	if ((envio==NULL) != (fin==NULL))
+		return -1;
+
+	p_proc_actual->anillo_env=envio;
+	p_proc_actual->anillo_fin=fin;
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema enviar_anillo. Pone en marcha las
+ * operaciones nuevas del anillo de envio y, si min_fin es mayor que 0,
+ * bloquea al proceso hasta que haya al menos min_fin finalizaciones sin
+ * consumir en el anillo de finalizacion. Solo se aceptan operaciones
+ * mientras quepan sus finalizaciones y haya peticiones libres en el
+ * nucleo; el resto se queda en el anillo. Devuelve el numero de
+ * operaciones aceptadas.
+ */
+int sis_enviar_anillo(){
+	int min_fin = (int)leer_registro(1);
+	anillo_envio *envio = p_proc_actual->anillo_env;
+	anillo_fin *fin = p_proc_actual->anillo_fin;
+	pet_async *pet;
+	int n = 0;
+	int nivel;
+
+	if (envio == NULL)
+		return -1;
+
+	nivel = fijar_nivel_int(NIVEL_3);
+	while (envio->cabeza != envio->cola)
+	{
+		if (p_proc_actual->en_vuelo + (fin->cola - fin->cabeza) >= TAM_ANILLO)
+			break;	/* no cabria su finalizacion */
+		if ((pet = reservar_pet()) == NULL)
+			break;
+		iniciar_op_async(pet, &(envio->entradas[envio->cabeza % TAM_ANILLO]));
+		envio->cabeza++;
+		n++;
+	}
+
+	// No se puede esperar mas de lo que puede llegar a terminar
+	if (min_fin > p_proc_actual->en_vuelo + (int)(fin->cola - fin->cabeza))
+		min_fin = p_proc_actual->en_vuelo + (int)(fin->cola - fin->cabeza);
+
+	if (min_fin > 0 && (int)(fin->cola - fin->cabeza) < min_fin)
+	{
+		//BLOQUEAR HASTA TENER min_fin FINALIZACIONES: publicar_fin nos despertara
+		BCP *actual = p_proc_actual;
+		actual->espera_fin = min_fin;
+		actual->estado = BLOQUEADO;
+		eliminar_elem(&lista_listos, actual);
+		insertar_ultimo(&lista_espera_anillo, actual);
+
+		p_proc_actual = planificador();
+		cambio_contexto(&(actual->contexto_regs), &(p_proc_actual->contexto_regs));
+	}
+
+	fijar_nivel_int(nivel);
+	return n;
+}
+
+/*
+ * Rutinas que indican si una llamada bloquearia al proceso actual con
+ * los parametros que hay en los registros. Las usa llamsis_lote.
+ */
+int bloquea_siempre(){
+
+	return 1;
+}
+
+int bloquearia_crearMutex(){
+
+	return (primer_mutex_libre == -1 && num_bloques_mutex == MAX_BLOQUES_MUTEX);
+}
+
+int bloquearia_lockMutex(){
+	unsigned int mutex_id = (unsigned int) leer_registro(1);
+	int posicion_mutex;
+
+	posicion_mutex = posicion_desc(p_proc_actual->lider, mutex_id);
+	if(posicion_mutex == -1 || MUTEX_EN(posicion_mutex).clase != CLASE_MUTEX)
+		return 0;
+	return (dueno_mutex(&(MUTEX_EN(posicion_mutex))) != NULL &&
+		dueno_mutex(&(MUTEX_EN(posicion_mutex))) != p_proc_actual);
+}
+
+int bloquearia_lock_timeout(){
+
+	return ((int)leer_registro(2) > 0 && bloquearia_lockMutex());
+}
+
+int bloquearia_lock_lectura(){
+	unsigned int desc = (unsigned int) leer_registro(1);
+	Mutex *rw = entrada_de(desc, CLASE_RWLOCK);
+
+	return (rw != NULL && lectura_bloquearia(rw, p_proc_actual, desc));
+}
+
+int bloquearia_lock_escritura(){
+	unsigned int desc = (unsigned int) leer_registro(1);
+	Mutex *rw = entrada_de(desc, CLASE_RWLOCK);
+
+	return (rw != NULL && dueno_mutex(rw) != p_proc_actual &&
+		num_lecturas(p_proc_actual, desc) == 0 &&
+		(dueno_mutex(rw) != NULL || rw->lectores > 0));
+}
+
+int bloquearia_sem_bajar(){
+	Mutex *sem = entrada_de((unsigned int) leer_registro(1), CLASE_SEMAFORO);
+
+	return (sem != NULL && sem->valor == 0);
+}
+
+int bloquearia_esperar_barrera(){
+	Mutex *bar = entrada_de((unsigned int) leer_registro(1), CLASE_BARRERA);
+
+	return (bar != NULL && bar->num_procesos_esperando + 1 < bar->valor);
+}
+
+int bloquearia_escribir(){
+	unsigned int longi = (unsigned int)leer_registro(2);
+
+	return (longi > hueco_salida());
+}
+
+int bloquearia_leer_term(){
+
+	return (term_recibidos == term_leidos);
+}
+
+int bloquearia_leer_linea(){
+	int n = (int)leer_registro(2);
+	unsigned int i;
+
+	if (n <= 1)
+		return 0;	/* no tiene que leer nada (o fallara) */
+	for (i = term_leidos; i != term_recibidos; i++)
+		if (buf_term[i % TAM_BUF_TERMINAL] == '\n' ||
+		    i - term_leidos + 1 >= n - 1)
+			return 0;
+	return 1;
+}
+
+int bloquearia_esperar_eventos(){
+	int conjunto = (int)leer_registro(1);
+	int timeout = (int)leer_registro(2);
+
+	if (conjunto & ~(EV_TERMINAL | (EV_TERMINAL - 1)))
+		return 0;	/* la llamada fallara sin bloquear */
+	for (int i = 0; i < NUM_MUT_PROC; i++)
+		if ((conjunto & EV_MUTEX(i)) &&
+		    posicion_desc(p_proc_actual->lider, i) == -1)
+			return 0;
+	return (timeout != 0 && eventos_listos(conjunto) == 0);
+}
+
+int bloquearia_enviar_anillo(){
+
+	return ((int)leer_registro(1) > 0);
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_proceso. Espera a que termine
+ * el hijo indicado (o cualquiera si pid es -1) y devuelve su identificador,
+ * dejando su estado de terminacion en la direccion recibida (si no es nula).
+ * Devuelve -1 si el proceso no tiene ningun hijo que cumpla la condicion.
+ */
+int sis_esperar_proceso(){
+	int pid = (int)leer_registro(1);
+	int *estado = (int *)leer_registro(2);
+	int hay_hijo = 0;
+	int hijo, estado_hijo;
+	BCP *p_proc;
+	int i;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	//BUSCAR UN HIJO QUE YA HAYA TERMINADO
+	for(i = 0; i < MAX_PROC; i++)
+	{
+		p_proc = &(tabla_procs[i]);
+		if(p_proc->padre != p_proc_actual || p_proc->estado == NO_USADA)
+			continue;
+		if(pid != -1 && pid != p_proc->id)
+			continue;
+
+		hay_hijo = 1;
+		if(p_proc->estado == ZOMBI)
+			break;
+	}
+
+	if(!hay_hijo)
+	{
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+
+	if(i < MAX_PROC)
+	{
+		//RECOGER EL ESTADO DEL HIJO TERMINADO
+		hijo = p_proc->id;
+		estado_hijo = p_proc->estado_fin;
+		p_proc->padre = NULL;
+		liberar_BCP_si_procede(p_proc);
+	}
+	else
+	{
+		//BLOQUEAR HASTA QUE TERMINE: liberar_proceso nos despertara
+		BCP *actual = p_proc_actual;
+		actual->espera_hijo = pid;
+		actual->estado = BLOQUEADO;
+		eliminar_elem(&lista_listos, actual);
+		insertar_ultimo(&lista_espera_hijos, actual);
+
+		p_proc_actual = planificador();
+		cambio_contexto(&(actual->contexto_regs), &(p_proc_actual->contexto_regs));
+
+		hijo = actual->hijo_recogido;
+		estado_hijo = actual->estado_hijo;
+	}
+
+	fijar_nivel_int(nivel);
+
+	if(estado != NULL)
+		*estado = estado_hijo;
+	return hijo;
+}
+
+int sis_dormir(){
+
+	//se lee el parametro de la llamada (segundos)
+	unsigned int segs = (unsigned int)leer_registro(1);
+
+	//fijar nivel interrupcion
+	int nivel = fijar_nivel_int(NIVEL_3);
 	//asginar tiempo dormido y pasar a lista dormidos
 	BCP *actual = p_proc_actual;
 	actual->segs_restantes = segs*TICK;
@@ -419,363 +2952,958 @@ int sis_dormir(){
 }
 
 
-// MUTEX
-
-int sis_crearMutex(){
-
-	char* nombre = (char*)leer_registro(1);
-	int tipo = (int) leer_registro(2);
+// MUTEX
+
+static int abrir_mutex(char *nombre, int clase);
+
+/*
+ * Funcion auxiliar que crea y abre un mutex, rwlock, semaforo, variable
+ * condicion o barrera (clase). En un rwlock, tipo es su politica, en un
+ * semaforo, su valor inicial y, en una barrera, sus participantes. Usada
+ * por las llamadas crear_....
+ */
+static int crear_mutex(char *nombre, int tipo, int clase){
+
+	int posicion_mutex;
+	int reintento = 0;
+
+	comprobar_limite_mutex();
+
+	//COMPROBAR QUE EL NOMBRE ES VALIDO
+	if(strlen(nombre) > MAX_NOM_MUT)
+	{
+		klog_aviso("Error: el nombre supera la longitud maxima\n");
+		return -1;
+	}
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	//COMPROBAR QUE EL NOMBRE ESTA LIBRE
+	if(buscar_mutex(nombre) != -1)
+	{
+		klog_aviso("Error: el nombre ya esta en uso\n");
+		fijar_nivel_int(nivel);
+		return -2;
+	}
+
+	//COMPROBAR QUE HAY HUECO EN LA LISTA DE DESRIPTORES
+	if(p_proc_actual->lider->descriptores_abiertos >= LIMITE_DESC_MUTEX)
+	{
+		klog_aviso("Error: no hay hueco en la lista de descriptores \n");
+		fijar_nivel_int(nivel);
+		return -3;
+	}
+
+	//SI NO HAY MUTEX LIBRE, BLOQUEA EL PROCESO HASTA QUE SE DESTRUYA UNO
+	while((posicion_mutex = reservar_mutex()) == -1)
+	{
+		klog_depura("bloquear proc mutex\n");
+		BCP* proc_a_bloquear = p_proc_actual;
+		proc_a_bloquear->estado = BLOQUEADO;
+
+		/* si ya estaba esperando no pierde su turno */
+		eliminar_elem(&lista_listos, proc_a_bloquear);
+		if(reintento)
+			insertar_primero(&lista_bloqueados_mutex, proc_a_bloquear);
+		else
+			insertar_ultimo(&lista_bloqueados_mutex, proc_a_bloquear);
+		reintento = 1;
+
+		p_proc_actual = planificador();
+		cambio_contexto(&(proc_a_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
+	}
+
+	//MIENTRAS ESPERABA OTRO HA PODIDO CREAR UNO CON EL MISMO NOMBRE
+	if(reintento && buscar_mutex(nombre) != -1)
+	{
+		MUTEX_EN(posicion_mutex).siguiente = primer_mutex_libre;
+		primer_mutex_libre = posicion_mutex;
+		klog_aviso("Error: el nombre ya esta en uso\n");
+		fijar_nivel_int(nivel);
+		return -2;
+	}
+
+	Mutex * mutex_a_crear = &(MUTEX_EN(posicion_mutex));
+	strcpy((mutex_a_crear->nombre),nombre);
+	mutex_a_crear->politica = POLITICA_ENTREGA;
+	mutex_a_crear->adelantos = 0;
+	memset(&(mutex_a_crear->estad), 0, sizeof(estad_mutex));
+	strcpy(mutex_a_crear->estad.nombre, nombre);
+	mutex_a_crear->clase = clase;
+	mutex_a_crear->palabra.tipo = (clase == CLASE_MUTEX) ? tipo : NO_RECURSIVO;
+	mutex_a_crear->preferencia = (clase == CLASE_RWLOCK) ? tipo : 0;
+	mutex_a_crear->valor = (clase == CLASE_SEMAFORO || clase == CLASE_BARRERA) ? tipo : 0;
+	mutex_a_crear->lectores = 0;
+	mutex_a_crear->estado = OCUPADO;
+	mutex_a_crear->num_procesos_esperando = 0;
+	fijar_dueno_mutex(mutex_a_crear, NULL);
+	mutex_a_crear->abiertos = 0;
+	insertar_nombre(posicion_mutex);
+
+	//ABRIMOS EL MUTEX QUE ACABAMOS DE CREAR
+	int descriptor = abrir_mutex(nombre, clase);
+
+	//MIENTRAS ESPERABA OTRO HILO HA PODIDO OCUPAR LOS DESCRIPTORES
+	if(descriptor < 0)
+	{
+		destruir_mutex(posicion_mutex);
+		descriptor = -3;
+	}
+
+	fijar_nivel_int(nivel);
+
+	return descriptor;
+}
+
+int sis_crearMutex(){
+
+	return crear_mutex((char*)leer_registro(1), (int) leer_registro(2),
+		CLASE_MUTEX);
+}
+
+/*
+ * Tratamiento de llamada al sistema crear_rwlock. Como crear_mutex, pero
+ * en lugar del tipo recibe la politica (PREF_ESCRITOR o PREF_LECTOR).
+ */
+int sis_crear_rwlock(){
+	int preferencia = (int) leer_registro(2);
+
+	if(preferencia != PREF_ESCRITOR && preferencia != PREF_LECTOR)
+		return -1;
+	return crear_mutex((char*)leer_registro(1), preferencia, CLASE_RWLOCK);
+}
+
+/*
+ * Funcion auxiliar que abre la entrada de la clase indicada con ese
+ * nombre en un descriptor libre del grupo. Solo los mutex tienen palabra
+ * visible desde la biblioteca, para que lock y unlock entren en el nucleo
+ * y fallen con el resto. Usada por las llamadas abrir_... y crear_mutex.
+ */
+static int abrir_mutex(char *nombre, int clase){
+
+	comprobar_limite_mutex();
+	int nivel = fijar_nivel_int(NIVEL_3);
+
+	//COMPROBAR SI EL NOMBRE EXISTE
+	int posicion_mutex = buscar_mutex(nombre);
+
+	if(posicion_mutex == -1 || MUTEX_EN(posicion_mutex).clase != clase)
+	{
+		klog_aviso("Error: nombre no válido \n");
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+
+	//RESERVAR EL DESCRIPTOR LIBRE MÁS BAJO
+	int posicion_descriptor_libre = reservar_desc(p_proc_actual->lider);
+
+	if(posicion_descriptor_libre == -1)
+	{
+		klog_aviso("Error: no hay descriptor libre \n");
+		fijar_nivel_int(nivel);
+		return -2;
+	}
+
+	// SI HAY DESCRIPTOR SE ABRE EL MUTEX
+	else
+	{
+		fijar_desc(p_proc_actual->lider, posicion_descriptor_libre, posicion_mutex,
+			(clase == CLASE_MUTEX) ? &(MUTEX_EN(posicion_mutex).palabra) : NULL);
+		MUTEX_EN(posicion_mutex).abiertos++;
+
+		klog_depura("Mutex abierto\n");
+		fijar_nivel_int(nivel);
+		return posicion_descriptor_libre;
+	}
+}
+
+int sis_abrirMutex(){
+
+	return abrir_mutex((char*)leer_registro(1), CLASE_MUTEX);
+}
+
+int sis_abrir_rwlock(){
+
+	return abrir_mutex((char*)leer_registro(1), CLASE_RWLOCK);
+}
+
+/*
+ * Funcion auxiliar que bloquea el mutex del descriptor indicado para el
+ * proceso actual. Si esta ocupado, espera sin limite si plazo es negativo,
+ * no espera si es 0 y, si es positivo, espera como mucho esos ticks: el
+ * proceso esta a la vez en la lista de espera del mutex y en la de plazos
+ * que revisa int_reloj, y sale de la que no le despierta. Devuelve 0 si lo
+ * consigue, -1 si el descriptor no es valido o el mutex se destruye, -2 si
+ * es un segundo lock de un mutex no recursivo y -3 si no lo consigue a
+ * tiempo. La lista de espera esta ordenada por prioridad y, mientras
+ * espera, el dueno del mutex hereda la suya (ver propagar_prioridad).
+ * Usada por lock, trylock y lock_timeout.
+ */
+static int lock_mutex(unsigned int mutex_id, int plazo){
+	int posicion_mutex;
+	Mutex *mutex;
+	BCP *dueno;
+	int vencido;
+	unsigned long long inicio;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	posicion_mutex = posicion_desc(p_proc_actual->lider, mutex_id);
+
+	// COMPROBAR SI EL MUTEX EXISTE (UN RWLOCK NO VALE)
+	if(posicion_mutex == -1 || MUTEX_EN(posicion_mutex).clase != CLASE_MUTEX)
+	{
+		klog_aviso("Error: el mutex no existe. Fallo en el lock.\n");
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+	mutex = &(MUTEX_EN(posicion_mutex));
+	dueno = dueno_mutex(mutex);
+
+	// SI EL MUTEX YA ESTÁ BLOQUEADO EL PROCESO PASA A ESTAR BLOQUEADO
+	if(dueno != p_proc_actual && dueno != NULL)
+	{
+		if(plazo == 0)
+		{
+			fijar_nivel_int(nivel);
+			return -3;	/* trylock: no espera */
+		}
+		klog_depura("El mutex se encuentra bloqueado, esperando...\n");
+
+		BCP * proc_A = p_proc_actual;
+		int reintento = 0;
+
+		inicio = leer_reloj_CMOS();
+		do
+		{
+			eliminar_elem(&lista_listos, proc_A);
+			// SI LO HAN DESPERTADO PARA COMPETIR Y HA PERDIDO, NO PIERDE SU TURNO
+			if(reintento && (mutex->lista_espera.primero == NULL ||
+			   mutex->lista_espera.primero->prioridad <= proc_A->prioridad))
+				insertar_primero(&(mutex->lista_espera), proc_A);
+			else
+				insertar_por_prioridad(&(mutex->lista_espera), proc_A);
+			if(reintento)
+				mutex->adelantos++;
+			proc_A->mutex_espera = mutex;
+			proc_A->concedido = 0;
+			mutex->num_procesos_esperando++;
+			if(lockstat_activo && mutex->num_procesos_esperando > mutex->estad.max_esperando)
+				mutex->estad.max_esperando = mutex->num_procesos_esperando;
+			actualizar_esperas_mutex(mutex);	/* su unlock entrara aqui */
+			propagar_prioridad(dueno_mutex(mutex));	/* el dueno hereda su prioridad */
+
+			vencido = bloquear_con_plazo(&(mutex->lista_espera),
+				(plazo > 0) ? plazo : 0);
+			proc_A->mutex_espera = NULL;
+
+			// EL UNLOCK LE PASA EL MUTEX, SALVO QUE SE HAYA DESTRUIDO, HAYA
+			// VENCIDO EL PLAZO (int_reloj ya lo ha sacado de la lista) O LO
+			// HAYA DEJADO LIBRE PARA QUE COMPITA POR EL (POLITICA_COMPETIR)
+			if(dueno_mutex(mutex) == proc_A)
+			{
+				anotar_espera(mutex, inicio);
+				fijar_nivel_int(nivel);
+				return 0;
+			}
+			if(vencido)
+			{
+				mutex->num_procesos_esperando--;
+				actualizar_esperas_mutex(mutex);
+				propagar_prioridad(dueno_mutex(mutex));
+				fijar_nivel_int(nivel);
+				return -3;
+			}
+			if(!proc_A->concedido ||
+			   posicion_desc(proc_A->lider, mutex_id) != posicion_mutex)
+			{
+				fijar_nivel_int(nivel);
+				return -1;
+			}
+			// REINTENTA CON LO QUE LE QUEDA DE PLAZO, QUE NO PUEDE SER 0:
+			// int_reloj SOLO LO AGOTA AL VENCER, Y ESO YA SE HA TRATADO
+			if(plazo > 0)
+				plazo = proc_A->ticks_plazo;
+			reintento = 1;
+		} while(dueno_mutex(mutex) != NULL);
+
+		fijar_dueno_mutex(mutex, proc_A);
+		mutex->adelantos = 0;
+		anotar_espera(mutex, inicio);
+		fijar_nivel_int(nivel);
+		return 0;
+	}
+
+	// SI NO ESTÁ BLOQUEADO POR NINGÚN OTRO PROCESO SE BLOQUEA Y SE GUARDA EL PROCESO QUE LO HA BLOQUEADO
+	else if(dueno == NULL)
+	{
+		fijar_dueno_mutex(mutex, p_proc_actual);
+		klog_depura("Mutex bloqueado\n");
+		fijar_nivel_int(nivel);
+		return 0;
+	}
+
+	// CASO EN EL QUE EL MISMO PROCESO BLOQUEA DE NUEVO EL MUTEX
+	else 
+	{
+		// SI NO ES RECURSIVO SALTARÁ UN ERROR PARA EVITAR UN INTERBLOQUEO
+		if(mutex->palabra.tipo == NO_RECURSIVO)
+		{
+			klog_aviso("Error: interbloqueo de mutex no recursivo\n");
+			fijar_nivel_int(nivel);
+			return -2;
+		}
+		// EN EL CASO DE QUE SEA RECURSIVO SE ACTUALIZA LA VARIABLE CORRESPONDIENTE
+		else
+		{
+			mutex->palabra.bloqueos++;
+			if(lockstat_activo)
+				mutex->estad.reentradas++;
+			klog_depura("Nuevo bloqueo en mutex recursivo. Número total de bloqueos: %d\n", mutex->palabra.bloqueos);
+			fijar_nivel_int(nivel);
+			return 0;
+		}
+	}
+}
+
+int sis_lockMutex(){
+
+	return lock_mutex((unsigned int) leer_registro(1), -1);
+}
+
+/*
+ * Tratamiento de llamada al sistema trylock. Como lock, pero si el mutex
+ * esta ocupado por otro proceso devuelve -3 sin esperar.
+ */
+int sis_trylockMutex(){
+
+	return lock_mutex((unsigned int) leer_registro(1), 0);
+}
+
+/*
+ * Tratamiento de llamada al sistema lock_timeout. Como lock, pero espera
+ * como mucho los ticks indicados (nada si no es positivo); si vencen,
+ * devuelve -3.
+ */
+int sis_lock_timeout(){
+	int ticks = (int) leer_registro(2);
+
+	return lock_mutex((unsigned int) leer_registro(1), (ticks > 0) ? ticks : 0);
+}
+
+/*
+ * Funcion auxiliar que suelta del todo el mutex, que tiene el proceso
+ * actual, pasandoselo al primero que espera (el de mas prioridad, que
+ * hereda la de los que quedan) o a la primera operacion OP_LOCK pendiente
+ * o dejandolo libre. Usada por unlock y cond_wait.
+ * Se llama con las interrupciones inhibidas.
+ */
+static void ceder_mutex(int posicion_mutex){
+	Mutex *mutex = &(MUTEX_EN(posicion_mutex));
+
+	// CON POLITICA_COMPETIR QUEDA LIBRE Y EL PRIMERO LO VUELVE A INTENTAR
+	if(mutex->lista_espera.primero != NULL &&
+	   mutex->politica == POLITICA_COMPETIR && mutex->adelantos < MAX_ADELANTOS)
+	{
+		BCP* aux = mutex->lista_espera.primero;
+		aux->estado = LISTO;
+		aux->mutex_espera = NULL;
+		aux->concedido = 1;
+		eliminar_primero(&(mutex->lista_espera));
+		insertar_ultimo(&lista_listos, aux);
+
+		fijar_dueno_mutex(mutex, NULL);
+		mutex->num_procesos_esperando--;
+		notificar_eventos(&(mutex->esperas_ev));
+	}
+	else if(mutex->lista_espera.primero != NULL)
+	{
+		BCP* aux = mutex->lista_espera.primero;
+		aux->estado = LISTO;
+		aux->mutex_espera = NULL;
+		eliminar_primero(&(mutex->lista_espera));
+		insertar_ultimo(&lista_listos, aux);
+
+		fijar_dueno_mutex(mutex, aux);
+		mutex->num_procesos_esperando--;
+		mutex->adelantos = 0;
+		propagar_prioridad(aux);
+	}
+	else if(mutex->lista_espera_async.primero != NULL)
+		conceder_lock_async(posicion_mutex);
+	else
+	{
+		fijar_dueno_mutex(mutex, NULL);
+		notificar_eventos(&(mutex->esperas_ev));
+	}
+	// DEJA DE HEREDAR LA PRIORIDAD DE LOS QUE ESPERABAN POR EL MUTEX
+	propagar_prioridad(p_proc_actual);
+}
+
+int sis_unlockMutex(){
+
+	unsigned int mutex_id = (unsigned int) leer_registro(1);
+	int posicion_mutex;
+	Mutex *mutex;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	posicion_mutex = posicion_desc(p_proc_actual->lider, mutex_id);
+
+	if(posicion_mutex == -1 || MUTEX_EN(posicion_mutex).clase != CLASE_MUTEX)
+	{
+		klog_aviso("Error: el mutex no existe. Fallo en el unlock.\n");
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+	mutex = &(MUTEX_EN(posicion_mutex));
+
+	if(dueno_mutex(mutex) != p_proc_actual)
+	{
+		klog_aviso("Error: se intentó desbloquear un mutex que fue bloqueado por otro proceso\n");
+		fijar_nivel_int(nivel);
+		return -2;
+	}
+
+	//DESBLOQUEAR MUTEX
+	mutex->palabra.bloqueos--;
+
+	if(mutex->palabra.bloqueos != 0)
+	{
+		//SE DESBLOQUEA UNA VEZ UN MUTEX RECURSIVO QUE HAY QUE DESBLOQUEAR MAS VECES
+		klog_depura("Bloqueos restantes: %d\n", mutex->palabra.bloqueos);
+		fijar_nivel_int(nivel);
+		return 0;
+	}
+	else
+	{
+		klog_depura("desbloqueando..\n");
+		ceder_mutex(posicion_mutex);
+		fijar_nivel_int(nivel);
+		return 0;
+	}
+}
+
+int sis_cerrarMutex(){
+
+	unsigned int mutex_id = (unsigned int) leer_registro(1);
+	int posicion_mutex;
+	Mutex *mutex;
 
 	int nivel = fijar_nivel_int(NIVEL_3);
-
-	//COMPROBAR QUE EL NOMBRE ES VALIDO
-	if(strlen(nombre) > MAX_NOM_MUT)
+	posicion_mutex = posicion_desc(p_proc_actual->lider, mutex_id);
+	if(posicion_mutex == -1)
 	{
-		printf("Error: el nombre supera la longitud maxima\n");
+		klog_aviso("Error: el mutex no existe. Fallo en el cierre.\n");
 		fijar_nivel_int(nivel);
 		return -1;
 	}
+	mutex = &(MUTEX_EN(posicion_mutex));
 
-	//COMPROBAR QUE EL NOMBRE ESTA LIBRE
-	for(int i = 0; i < NUM_MUT; i++)
+	//UN RWLOCK SE SUELTA PARA TODO EL GRUPO
+	if(mutex->clase == CLASE_RWLOCK)
+		soltar_rwlock(mutex, mutex_id);
+
+	//SI LO TIENE BLOQUEADO EL PROCESO, SE DESBLOQUEA DEL TODO
+	else if(dueno_mutex(mutex) == p_proc_actual)
 	{
-		if((strcmp(nombre, sis_lista_mutex[i].nombre)) == 0)
-		{
-			printf("Error: el nombre ya esta en uso\n");
-			fijar_nivel_int(nivel);
-			return -2;
-		}
+		klog_depura("El proceso que lockeo el mutex %s lo ha cerrado\n", mutex->nombre);
+		mutex->palabra.bloqueos = 1;
+		escribir_registro(1, mutex_id);
+		sis_unlockMutex();
 	}
-	
-	//COMPROBAR QUE HAY HUECO EN LA LISTA DE DESRIPTORES
-	int descriptor_libre_encontrado = 0;
-	int posicion_descriptor_libre = -1;
-	int i  = 0;
-	if(p_proc_actual->descriptores_abiertos < NUM_MUT_PROC)
+
+	liberar_desc(p_proc_actual->lider, mutex_id);
+
+	//EL ULTIMO CIERRE DESTRUYE EL MUTEX
+	if(--mutex->abiertos == 0)
 	{
-		
-		while(descriptor_libre_encontrado == 0 && i < NUM_MUT_PROC)
-		{
-			if (p_proc_actual->descriptores[i] == -1)
-			{
-				descriptor_libre_encontrado = 1;
-				posicion_descriptor_libre = i;
-			}
-			else{
-				i++;
-			}
-		}
-	}else
+		klog_depura("Mutex %s destruido\n", mutex->nombre);
+		destruir_mutex(posicion_mutex);
+	}
+
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema lock_lectura. Bloquea para leer el
+ * rwlock del descriptor, esperando si hay un escritor dentro o, con
+ * PREF_ESCRITOR, esperando. Un proceso puede tener varias lecturas a la
+ * vez. Devuelve 0 si lo consigue, -1 si el descriptor no es de un rwlock
+ * o se cierra mientras espera y -2 si ya lo tiene para escribir.
+ */
+int sis_lock_lectura(){
+	unsigned int desc = (unsigned int) leer_registro(1);
+	Mutex *rw;
+	BCP *actual;
+	int *lecturas;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((rw = entrada_de(desc, CLASE_RWLOCK)) == NULL)
 	{
-		printf("Error: no hay hueco en la lista de descriptores \n");
 		fijar_nivel_int(nivel);
-		return -3;
+		return -1;
 	}
-	
-		//COMPROBAR QUE HAY MUTEX LIBRES
-	int mutex_libre_encontrado = 0;
-	int posicion_mutex_libre = -1;
-	int j = 0;
-	while(mutex_libre_encontrado == 0 && j < NUM_MUT)
+	if(dueno_mutex(rw) == p_proc_actual)
 	{
-		if (sis_lista_mutex[j].estado == LIBRE)
-		{
-			//printf("encotrado %d\n", j);
-			
-			mutex_libre_encontrado = 1;
-			posicion_mutex_libre = j;
-		}
-		else{
-			j++;
-		}
+		klog_aviso("Error: lectura de un rwlock que ya se tiene para escribir\n");
+		fijar_nivel_int(nivel);
+		return -2;
 	}
-	//printf(" %d\n", j);
 
-	if(mutex_libre_encontrado != 1)
+	// EL CONTADOR SE RESERVA ANTES DE ESPERAR: conceder_rwlock LO USA
+	if((lecturas = lecturas_desc(p_proc_actual, desc)) == NULL)
 	{
-		//SI NO HAY MUTEX LIBRE, BLOQUEA EL PROCESO
-		/*
-		BCP* proc_a_bloquear = p_proc_actual;
-		proc_a_bloquear->estado = BLOQUEADO;
-		eliminar_primero(&lista_listos);
-		insertar_ultimo(&lista_bloqueados_mutex, proc_a_bloquear);
-		p_proc_actual = planificador();
-		cambio_contexto(&(p_proc_a_expulsar->contexto_regs), &(p_proc_actual->contexto_regs));
-		printf("Error: no hay mutex libres \n");
-	
-		fijar_nivel_int(nivel);s
-		return -4;
-		*/
-		printf("bloquear proc mutex");
-		BCP* proc_a_bloquear = p_proc_actual;
-		proc_a_bloquear->estado = BLOQUEADO;
-
-		eliminar_primero(&lista_listos);
-		insertar_ultimo(&lista_bloqueados_mutex, proc_a_bloquear);
-
-		p_proc_actual = planificador();
-		cambio_contexto(&(proc_a_bloquear->contexto_regs), &(p_proc_actual->contexto_regs));
+		fijar_nivel_int(nivel);
+		return -1;
 	}
 
-	Mutex * mutex_a_crear = &(sis_lista_mutex[posicion_mutex_libre]);
-	strcpy((mutex_a_crear->nombre),nombre);
-	mutex_a_crear->tipo = tipo;
-	mutex_a_crear->num_bloqueos = 0;
-	mutex_a_crear->estado = OCUPADO;
-	mutex_a_crear->num_procesos_esperando = 0;
-	mutex_a_crear->proc_mut = NULL;
+	// SI NO TIENE QUE ESPERAR, ENTRA DIRECTAMENTE
+	if(!lectura_bloquearia(rw, p_proc_actual, desc))
+	{
+		rw->lectores++;
+		(*lecturas)++;
+		fijar_nivel_int(nivel);
+		return 0;
+	}
 
-	//ABRIMOS EL MUTEX QUE ACABAMOS DE CREAR
-	escribir_registro(1, (long) nombre);
-	sis_abrirMutex();
+	// SI NO, ESPERA A QUE conceder_rwlock LE DE LA LECTURA
+	actual = p_proc_actual;
+	actual->lectura_espera = desc;
+	eliminar_elem(&lista_listos, actual);
+	insertar_ultimo(&(rw->lista_lectores), actual);
+	bloquear_con_plazo(&(rw->lista_lectores), 0);
 
 	fijar_nivel_int(nivel);
-
-	return posicion_descriptor_libre;
+	return (num_lecturas(actual, desc) > 0) ? 0 : -1;
 }
 
-int sis_abrirMutex(){
+/*
+ * Tratamiento de llamada al sistema lock_escritura. Bloquea para escribir
+ * el rwlock del descriptor, esperando a que no quede nadie dentro. Como en
+ * un mutex, la lista de espera de los escritores esta ordenada por
+ * prioridad y el escritor que esta dentro hereda la suya. Devuelve 0 si lo
+ * consigue, -1 si el descriptor no es de un rwlock o se cierra mientras
+ * espera y -2 si el proceso ya lo tiene (para leer o escribir).
+ */
+int sis_lock_escritura(){
+	unsigned int desc = (unsigned int) leer_registro(1);
+	Mutex *rw;
+	BCP *actual;
 
-	char * nombre  = (char*)leer_registro(1);
 	int nivel = fijar_nivel_int(NIVEL_3);
-
-	//COMPROBAR SI EL NOMBRE EXISTE
-	int i = 0;
-	int mutex_encontrado = 0;
-	int posicion_mutex_libre = -1;
-	
-	while(i < NUM_MUT && mutex_encontrado == 0)
+	if((rw = entrada_de(desc, CLASE_RWLOCK)) == NULL)
 	{
-		if (strcmp(nombre, sis_lista_mutex[i].nombre) == 0)
-		{
-			mutex_encontrado = 1;
-			posicion_mutex_libre = i;
-		}
-		else{
-			i++;
-		}
+		fijar_nivel_int(nivel);
+		return -1;
 	}
-	if(mutex_encontrado == 0)
+	if(dueno_mutex(rw) == p_proc_actual || num_lecturas(p_proc_actual, desc) > 0)
 	{
-		printf("Error: nombre no válido \n");
+		klog_aviso("Error: interbloqueo en la escritura de un rwlock\n");
 		fijar_nivel_int(nivel);
-		return -1;
+		return -2;
 	}
 
-	//COMPROBAR SI HAY ALGÚN DESCRIPTOR LIBRE
-	i = 0;
-	int descriptor_libre_encontrado = 0;
-	int posicion_descriptor_libre;
-
-	while(i < NUM_MUT_PROC && descriptor_libre_encontrado == 0)
+	if(dueno_mutex(rw) == NULL && rw->lectores == 0)
 	{
-		if (p_proc_actual->descriptores[i] == -1)
-		{
-			descriptor_libre_encontrado = 1;
-			posicion_descriptor_libre = i;
-		}
-		else{
-			i++;
-		}
+		fijar_dueno_mutex(rw, p_proc_actual);
+		fijar_nivel_int(nivel);
+		return 0;
 	}
 
-	if(descriptor_libre_encontrado == 0)
+	actual = p_proc_actual;
+	eliminar_elem(&lista_listos, actual);
+	insertar_por_prioridad(&(rw->lista_espera), actual);
+	actual->mutex_espera = rw;
+	rw->num_procesos_esperando++;
+	actualizar_esperas_mutex(rw);
+	propagar_prioridad(dueno_mutex(rw));
+	bloquear_con_plazo(&(rw->lista_espera), 0);
+	actual->mutex_espera = NULL;
+
+	fijar_nivel_int(nivel);
+	return (dueno_mutex(rw) == actual) ? 0 : -1;
+}
+
+/*
+ * Tratamiento de llamada al sistema unlock_rw. Suelta la escritura o una
+ * de las lecturas que tiene el proceso del rwlock del descriptor y, si
+ * queda libre, se lo pasa a los que esperan (ver conceder_rwlock).
+ * Devuelve 0 si lo consigue, -1 si el descriptor no es de un rwlock y -2
+ * si el proceso no lo tiene.
+ */
+int sis_unlock_rw(){
+	unsigned int desc = (unsigned int) leer_registro(1);
+	Mutex *rw;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((rw = entrada_de(desc, CLASE_RWLOCK)) == NULL)
 	{
-		printf("Error: no hay descriptor libre \n");
 		fijar_nivel_int(nivel);
-		return -2;
+		return -1;
 	}
 
-	// SI HAY DESCRIPTOR SE ABRE EL MUTEX
+	if(dueno_mutex(rw) == p_proc_actual)
+	{
+		fijar_dueno_mutex(rw, NULL);
+		conceder_rwlock(rw, 1);
+		propagar_prioridad(p_proc_actual);
+	}
+	else if(num_lecturas(p_proc_actual, desc) > 0)
+	{
+		(*lecturas_desc(p_proc_actual, desc))--;
+		rw->lectores--;
+		conceder_rwlock(rw, 0);
+	}
 	else
 	{
-		p_proc_actual->descriptores[posicion_descriptor_libre] = posicion_mutex_libre;
-		p_proc_actual->descriptores_abiertos++;
-
-		printf("Mutex abierto\n");
+		klog_aviso("Error: unlock_rw de un rwlock que no se tiene\n");
 		fijar_nivel_int(nivel);
-		return posicion_descriptor_libre;
+		return -2;
 	}
+	fijar_nivel_int(nivel);
+	return 0;
 }
 
-int sis_lockMutex(){
+/*
+ * Tratamiento de llamada al sistema crear_semaforo. Como crear_mutex, pero
+ * en lugar del tipo recibe el valor inicial, que no puede ser negativo.
+ */
+int sis_crear_semaforo(){
+	int valor = (int) leer_registro(2);
 
-	unsigned int mutex_id = (unsigned int) leer_registro(1);
-	int nivel = fijar_nivel_int(NIVEL_3);
-	int posicion_mutex = p_proc_actual->descriptores[mutex_id];
+	if(valor < 0)
+		return -1;
+	return crear_mutex((char*)leer_registro(1), valor, CLASE_SEMAFORO);
+}
 
-	// COMPROBAR SI EL MUTEX EXISTE
-	if(posicion_mutex == -1)
+int sis_abrir_semaforo(){
+
+	return abrir_mutex((char*)leer_registro(1), CLASE_SEMAFORO);
+}
+
+/*
+ * Tratamiento de llamada al sistema sem_bajar. Toma una unidad del
+ * semaforo del descriptor o, si no hay, espera a que sem_subir se la de.
+ * Devuelve 0 si la consigue y -1 si el descriptor no es de un semaforo o
+ * el semaforo se destruye mientras espera.
+ */
+int sis_sem_bajar(){
+	Mutex *sem;
+	BCP *actual;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((sem = entrada_de((unsigned int) leer_registro(1), CLASE_SEMAFORO)) == NULL)
 	{
-		printf("Error: el mutex no existe. Fallo en el lock.\n");
 		fijar_nivel_int(nivel);
 		return -1;
 	}
+	if(sem->valor > 0)
+	{
+		sem->valor--;
+		fijar_nivel_int(nivel);
+		return 0;
+	}
 
-	// SI EL MUTEX YA ESTÁ BLOQUEADO EL PROCESO PASA A ESTAR BLOQUEADO
-	if(sis_lista_mutex[posicion_mutex].proc_mut != p_proc_actual && sis_lista_mutex[posicion_mutex].proc_mut != NULL)
+	actual = p_proc_actual;
+	actual->concedido = 0;
+	eliminar_elem(&lista_listos, actual);
+	insertar_ultimo(&(sem->lista_espera), actual);
+	sem->num_procesos_esperando++;
+	bloquear_con_plazo(&(sem->lista_espera), 0);
+
+	fijar_nivel_int(nivel);
+	return actual->concedido ? 0 : -1;
+}
+
+/*
+ * Tratamiento de llamada al sistema sem_subir. Anade n unidades al semaforo
+ * del descriptor: se dan directamente, de una vez, a los primeros n que
+ * esperan y el resto se suma a su valor. Devuelve 0 o -1 si el descriptor
+ * no es de un semaforo o n no es positivo.
+ */
+int sis_sem_subir(){
+	int n = (int) leer_registro(2);
+	Mutex *sem;
+	BCP *p_proc;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((sem = entrada_de((unsigned int) leer_registro(1), CLASE_SEMAFORO)) == NULL || n <= 0)
+	{
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+	while(n > 0 && (p_proc = sem->lista_espera.primero) != NULL)
 	{
-		printf("El mutex se encuentra bloqueado, esperando...\n");
+		eliminar_primero(&(sem->lista_espera));
+		sem->num_procesos_esperando--;
+		p_proc->concedido = 1;
+		p_proc->estado = LISTO;
+		insertar_ultimo(&lista_listos, p_proc);
+		n--;
+	}
+	sem->valor += n;
+	if(sem->valor > 0)
+		notificar_eventos(&(sem->esperas_ev));
 
-		BCP * proc_A = p_proc_actual;
-		proc_A->estado = BLOQUEADO;
+	fijar_nivel_int(nivel);
+	return 0;
+}
 
-		eliminar_elem(&lista_listos, proc_A);
-		insertar_ultimo(&(sis_lista_mutex[posicion_mutex].lista_espera), proc_A);
-		sis_lista_mutex[posicion_mutex].num_procesos_esperando++;
+int sis_crear_condicion(){
 
-		p_proc_actual = planificador();
+	return crear_mutex((char*)leer_registro(1), 0, CLASE_CONDICION);
+}
+
+int sis_abrir_condicion(){
+
+	return abrir_mutex((char*)leer_registro(1), CLASE_CONDICION);
+}
 
-		cambio_contexto(&(proc_A->contexto_regs), &(p_proc_actual->contexto_regs));
+/*
+ * Tratamiento de llamada al sistema cond_wait. Suelta el mutex, que debe
+ * tener el proceso (sin bloqueos recursivos pendientes), y espera en la
+ * variable condicion hasta que cond_signal o cond_broadcast lo pasen a
+ * esperar por el mutex. Devuelve 0 cuando vuelve a tener el mutex, -1 si
+ * algun descriptor no es valido o la condicion o el mutex se destruyen
+ * mientras espera (y entonces no tiene el mutex) y -2 si no tiene el mutex.
+ */
+int sis_cond_wait(){
+	unsigned int mutex_id = (unsigned int) leer_registro(2);
+	int posicion_mutex;
+	Mutex *cond, *mutex;
+	BCP *actual;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((cond = entrada_de((unsigned int) leer_registro(1), CLASE_CONDICION)) == NULL ||
+	   (mutex = entrada_de(mutex_id, CLASE_MUTEX)) == NULL)
+	{
+		fijar_nivel_int(nivel);
+		return -1;
+	}
+	if(dueno_mutex(mutex) != p_proc_actual || mutex->palabra.bloqueos != 1)
+	{
+		klog_aviso("Error: cond_wait sin tener el mutex\n");
 		fijar_nivel_int(nivel);
+		return -2;
 	}
+	posicion_mutex = posicion_desc(p_proc_actual->lider, mutex_id);
+	ceder_mutex(posicion_mutex);
 
-	// SI NO ESTÁ BLOQUEADO POR NINGÚN OTRO PROCESO SE BLOQUEA Y SE GUARDA EL PROCESO QUE LO HA BLOQUEADO
-	else if(sis_lista_mutex[posicion_mutex].proc_mut == NULL)
+	actual = p_proc_actual;
+	actual->mutex_cond = mutex;
+	actual->concedido = 0;
+	eliminar_elem(&lista_listos, actual);
+	insertar_ultimo(&(cond->lista_espera), actual);
+	cond->num_procesos_esperando++;
+	bloquear_con_plazo(&(cond->lista_espera), 0);
+	actual->mutex_cond = NULL;
+
+	// CON POLITICA_COMPETIR EL UNLOCK SOLO LE DESPIERTA: TIENE QUE COGERLO
+	if(dueno_mutex(mutex) != actual && actual->concedido)
 	{
-		sis_lista_mutex[posicion_mutex].proc_mut = p_proc_actual;
-		sis_lista_mutex[posicion_mutex].num_bloqueos++;
-		printf("Mutex bloqueado\n");
 		fijar_nivel_int(nivel);
-		return 0;
+		return lock_mutex(mutex_id, -1);
 	}
 
-	// CASO EN EL QUE EL MISMO PROCESO BLOQUEA DE NUEVO EL MUTEX
-	else 
+	fijar_nivel_int(nivel);
+	return (dueno_mutex(mutex) == actual) ? 0 : -1;
+}
+
+/*
+ * Funcion auxiliar que saca de la variable condicion al primero que
+ * espera, o a todos, y los pasa directamente a la lista de espera del
+ * mutex que soltaron (o les da el mutex si esta libre), sin despertarlos:
+ * los despertara el unlock que se lo pase, de uno en uno. Devuelve cuantos
+ * ha sacado. Usada por cond_signal y cond_broadcast.
+ * Se llama con las interrupciones inhibidas.
+ */
+static int despertar_condicion(Mutex *cond, int todos){
+	BCP *p_proc;
+	Mutex *mutex;
+	int n = 0;
+
+	while((p_proc = cond->lista_espera.primero) != NULL)
 	{
-		// SI NO ES RECURSIVO SALTARÁ UN ERROR PARA EVITAR UN INTERBLOQUEO
-		if(sis_lista_mutex[posicion_mutex].num_bloqueos == 1 && sis_lista_mutex[posicion_mutex].tipo == NO_RECURSIVO)
+		eliminar_primero(&(cond->lista_espera));
+		cond->num_procesos_esperando--;
+		mutex = p_proc->mutex_cond;
+
+		// SI EL MUTEX YA NO EXISTE FALLA, Y SI ESTA LIBRE SE LO QUEDA
+		if(mutex->estado == LIBRE || mutex->clase != CLASE_MUTEX ||
+		   dueno_mutex(mutex) == NULL)
 		{
-			printf("Error: interbloqueo de mutex no recursivo\n");
-			fijar_nivel_int(nivel);
-			return -2;
+			if(mutex->estado != LIBRE && mutex->clase == CLASE_MUTEX)
+				fijar_dueno_mutex(mutex, p_proc);
+			p_proc->estado = LISTO;
+			insertar_ultimo(&lista_listos, p_proc);
 		}
-		// EN EL CASO DE QUE SEA RECURSIVO SE ACTUALIZA LA VARIABLE CORRESPONDIENTE
 		else
 		{
-			sis_lista_mutex[posicion_mutex].num_bloqueos++;
-			printf("Nuevo bloqueo en mutex recursivo. Número total de bloqueos: %d\n", sis_lista_mutex[posicion_mutex].num_bloqueos);
-			fijar_nivel_int(nivel);
-			return 0;
+			insertar_por_prioridad(&(mutex->lista_espera), p_proc);
+			p_proc->mutex_espera = mutex;
+			mutex->num_procesos_esperando++;
+			actualizar_esperas_mutex(mutex);	/* su unlock entrara aqui */
+			propagar_prioridad(dueno_mutex(mutex));
 		}
+		n++;
+		if(!todos)
+			break;
 	}
+	return n;
 }
 
-int sis_unlockMutex(){
+/*
+ * Tratamiento de llamadas al sistema cond_signal y cond_broadcast.
+ * Devuelven cuantos procesos han dejado de esperar en la variable
+ * condicion o -1 si el descriptor no es de una.
+ */
+int sis_cond_signal(){
+	Mutex *cond;
+	int n;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	cond = entrada_de((unsigned int) leer_registro(1), CLASE_CONDICION);
+	n = cond ? despertar_condicion(cond, 0) : -1;
+	fijar_nivel_int(nivel);
+	return n;
+}
+
+int sis_cond_broadcast(){
+	Mutex *cond;
+	int n;
 
-	unsigned int mutex_id = (unsigned int) leer_registro(1);
 	int nivel = fijar_nivel_int(NIVEL_3);
-	int posicion_mutex = p_proc_actual->descriptores[mutex_id];
+	cond = entrada_de((unsigned int) leer_registro(1), CLASE_CONDICION);
+	n = cond ? despertar_condicion(cond, 1) : -1;
+	fijar_nivel_int(nivel);
+	return n;
+}
 
-	if(posicion_mutex == -1)
-	{
-		printf("Error: el mutex no existe. Fallo en el unlock.\n");
-		fijar_nivel_int(nivel);
+/*
+ * Tratamiento de llamada al sistema crear_barrera. Como crear_mutex, pero
+ * en lugar del tipo recibe el numero de participantes, al menos 1.
+ */
+int sis_crear_barrera(){
+	int participantes = (int) leer_registro(2);
+
+	if(participantes < 1)
 		return -1;
-	}
+	return crear_mutex((char*)leer_registro(1), participantes, CLASE_BARRERA);
+}
 
-	if(sis_lista_mutex[posicion_mutex].proc_mut != p_proc_actual)
-	{
-		printf("Error: se intentó desbloquear un mutex que fue bloqueado por otro proceso\n");
-		fijar_nivel_int(nivel);
-		return -2;
-	}
+int sis_abrir_barrera(){
 
-	//DESBLOQUEAR MUTEX
-	sis_lista_mutex[posicion_mutex].num_bloqueos--;
+	return abrir_mutex((char*)leer_registro(1), CLASE_BARRERA);
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_barrera. Espera a que lleguen
+ * a la barrera del descriptor todos sus participantes. El ultimo en llegar
+ * no espera: pasa a los demas a listos de una vez, empalmando la lista de
+ * espera de la barrera al final de la de listos, y la deja preparada para
+ * la siguiente vuelta. Devuelve 1 al ultimo, 0 al resto y -1 si el
+ * descriptor no es de una barrera o esta se destruye mientras espera.
+ */
+int sis_esperar_barrera(){
+	Mutex *bar;
+	BCP *actual, *p_proc;
 
-	if(sis_lista_mutex[posicion_mutex].num_bloqueos != 0)
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((bar = entrada_de((unsigned int) leer_registro(1), CLASE_BARRERA)) == NULL)
 	{
-		//SE DESBLOQUEA UNA VEZ UN MUTEX RECURSIVO QUE HAY QUE DESBLOQUEAR MAS VECES
-		printf("Bloqueos restantes: %d", sis_lista_mutex[posicion_mutex].num_bloqueos);
 		fijar_nivel_int(nivel);
-		return 0;
+		return -1;
 	}
-	else
+
+	// EL ULTIMO DA PASO A TODOS
+	if(bar->num_procesos_esperando + 1 >= bar->valor)
 	{
-		printf("desbloqueando..\n");
-		sis_lista_mutex[posicion_mutex].proc_mut=NULL;
-		if(sis_lista_mutex[posicion_mutex].lista_espera.primero != NULL)
+		for(p_proc = bar->lista_espera.primero; p_proc; p_proc = p_proc->siguiente)
 		{
-			BCP* aux = sis_lista_mutex[posicion_mutex].lista_espera.primero;
-			aux->estado = LISTO;
-			eliminar_primero(&(sis_lista_mutex[posicion_mutex].lista_espera));
-			insertar_ultimo(&lista_listos, aux);
-
-			sis_lista_mutex[posicion_mutex].proc_mut = aux;
-			
+			p_proc->concedido = 1;
+			p_proc->estado = LISTO;
 		}
+		empalmar_lista(&lista_listos, &(bar->lista_espera));
+		bar->num_procesos_esperando = 0;
 		fijar_nivel_int(nivel);
-		return 0;
+		return 1;
 	}
-}
 
-int sis_cerrarMutex(){
+	actual = p_proc_actual;
+	actual->concedido = 0;
+	eliminar_elem(&lista_listos, actual);
+	insertar_ultimo(&(bar->lista_espera), actual);
+	bar->num_procesos_esperando++;
+	bloquear_con_plazo(&(bar->lista_espera), 0);
+
+	fijar_nivel_int(nivel);
+	return actual->concedido ? 0 : -1;
+}
 
+/*
+ * Tratamiento de llamada al sistema fijar_politica_mutex. Cambia lo que
+ * hace unlock con el mutex del descriptor cuando hay procesos esperando
+ * (POLITICA_ENTREGA o POLITICA_COMPETIR). Devuelve la politica que tenia
+ * o -1 si el descriptor no es de un mutex o la politica no es valida.
+ */
+int sis_fijar_politica_mutex(){
 	unsigned int mutex_id = (unsigned int) leer_registro(1);
-	int nivel = fijar_nivel_int(NIVEL_3);
-	int posicion_mutex = p_proc_actual->descriptores[mutex_id];
+	int politica = (int) leer_registro(2);
+	Mutex *mutex;
+	int anterior;
 
-	if(posicion_mutex == -1)
+	if(politica != POLITICA_ENTREGA && politica != POLITICA_COMPETIR)
+		return -1;
+	int nivel = fijar_nivel_int(NIVEL_3);
+	if((mutex = entrada_de(mutex_id, CLASE_MUTEX)) == NULL)
 	{
-		printf("Error: el mutex no existe. Fallo en el unlock.\n");
 		fijar_nivel_int(nivel);
 		return -1;
 	}
+	anterior = mutex->politica;
+	mutex->politica = politica;
+	mutex->adelantos = 0;
+	fijar_nivel_int(nivel);
+	return anterior;
+}
 
-	//DESBLOQUEAR EL MUTEX
-	printf("Numero de bloqueos de %s: %d\n", sis_lista_mutex[mutex_id].nombre, sis_lista_mutex[mutex_id].num_bloqueos);
-	if(sis_lista_mutex[mutex_id].num_bloqueos > 0)
+/*
+ * Tratamiento de llamada al sistema estad_cerrojos. Copia en el vector
+ * recibido (hasta n entradas) las estadisticas de contencion de los mutex
+ * que las tienen, existan todavia o no, y despues hace lo que indica el
+ * modo (LOCKSTAT_...). Al activarlas se olvida cuando cogieron sus duenos
+ * los mutex que estan bloqueados, ya que pudo ser sin entrar en el nucleo.
+ * Devuelve el numero de entradas copiadas.
+ */
+int sis_estad_cerrojos(){
+	estad_mutex *v = (estad_mutex *)leer_registro(1);
+	int n = (int)leer_registro(2);
+	int modo = (int)leer_registro(3);
+	int pos, copiadas = 0;
+	Mutex *mutex;
+
+	int nivel = fijar_nivel_int(NIVEL_3);
+	for(pos = 0; pos < num_bloques_mutex*MUTEX_POR_BLOQUE && pos < LIMITE_MUTEX; pos++)
 	{
-		printf("Cerrando un mutex lockeado: %s\n", sis_lista_mutex[mutex_id].nombre);
-		if(sis_lista_mutex[mutex_id].proc_mut == p_proc_actual)
+		mutex = &(MUTEX_EN(pos));
+		if(v != NULL && copiadas < n &&
+		   (mutex->estad.adquisiciones > 0 || mutex->estad.reentradas > 0))
+			v[copiadas++] = mutex->estad;
+		if(modo & LOCKSTAT_REINICIAR)
 		{
-			printf("El proceso que lockeo  el mutex lo ha cerrado\n");
-			while(sis_lista_mutex[mutex_id].num_bloqueos > 0)
-				{
-					printf("Desbloqueos restantes: %d\n", sis_lista_mutex[mutex_id].num_bloqueos);
-					escribir_registro(1, mutex_id);
-					sis_unlockMutex();
-				}				
-		}else
-		{
-			sis_lista_mutex[mutex_id].estado = LIBRE;
-			p_proc_actual->descriptores[mutex_id] = -1;
-			p_proc_actual->descriptores_abiertos--;
-
-			if(lista_bloqueados_mutex.primero!= NULL)
-			{
-				BCP* proc = lista_bloqueados_mutex.primero;
-				proc->estado = LISTO;
-				eliminar_primero(&lista_bloqueados_mutex);
-				insertar_ultimo(&lista_listos, proc);
-				
-			}
-			fijar_nivel_int(nivel);
-			printf("Mutex %s cerrado\n", sis_lista_mutex[posicion_mutex].nombre);
-			return 0;
+			memset(&(mutex->estad), 0, sizeof(estad_mutex));
+			strcpy(mutex->estad.nombre, mutex->nombre);
 		}
-		
-	}
-	sis_lista_mutex[posicion_mutex].estado = LIBRE;
-	sis_lista_mutex[posicion_mutex].proc_mut = NULL;
-	sis_lista_mutex[posicion_mutex].num_procesos_esperando = 0;
-	
-	p_proc_actual->descriptores[mutex_id] = -1;
-	p_proc_actual->descriptores_abiertos--;
-
-	if(lista_bloqueados_mutex.primero!= NULL)
-	{
-		BCP* proc = lista_bloqueados_mutex.primero;
-		proc->estado = LISTO;
-		eliminar_primero(&lista_bloqueados_mutex);
-		insertar_ultimo(&lista_listos, proc);
-		
+		if(modo & LOCKSTAT_ACTIVAR)
+			mutex->inicio_retencion = 0;
 	}
-
+	if(modo & LOCKSTAT_ACTIVAR)
+		lockstat_activo = 1;
+	if(modo & LOCKSTAT_PARAR)
+		lockstat_activo = 0;
+	publicar_proc_usuario(p_proc_actual);
 	fijar_nivel_int(nivel);
-	printf("Mutex %s cerrado\n", sis_lista_mutex[posicion_mutex].nombre);
-	return 0;
+	return copiadas;
 }
 
 /*
@@ -786,15 +3914,10 @@ int sis_cerrarMutex(){
 int main(){
 	/* se llega con las interrupciones prohibidas */
 
+	tiempo_arranque = leer_reloj_CMOS();
+
 	/* inicializar mutex */
-	for(int i = 0; i < NUM_MUT; i++)
-	{
-		//printf("mutex inicializado %d\n", i);
-		sis_lista_mutex[i].estado = LIBRE;
-		sis_lista_mutex[i].proc_mut = NULL;
-		sis_lista_mutex[i].num_procesos_esperando = 0;
-		sis_lista_mutex[i].num_bloqueos = 0;
-	}
+	iniciar_tabla_mutex();
 
 	instal_man_int(EXC_ARITM, exc_arit); 
 	instal_man_int(EXC_MEM, exc_mem); 
@@ -810,7 +3933,7 @@ int main(){
 	iniciar_tabla_proc();		/* inicia BCPs de tabla de procesos */
 
 	/* crea proceso inicial */
-	if (crear_tarea((void *)"init")<0)
+	if (crear_tarea((void *)"init", NULL)<0)
 		panico("no encontrado el proceso inicial");
 	
 	/* activa proceso inicial */
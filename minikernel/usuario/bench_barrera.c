@@ -0,0 +1,85 @@
+/*
+ * usuario/bench_barrera.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que mide el tiempo de una vuelta de barrera (desde
+ * que la deja el primero hasta que vuelven a llegar todos y la deja el
+ * siguiente) con distinto numero de participantes: el proceso y varios
+ * hilos suyos. Comprueba también que en cada vuelta exactamente uno
+ * recibe 1 de esperar_barrera y que nadie adelanta a los demas.
+ */
+
+#include "servicios.h"
+
+#define TOT_VUELTAS 20000	/* vueltas de cada medida */
+#define MAX_PARTICIPANTES 8	/* el proceso, 7 hilos y init: MAX_PROC */
+
+int bar;
+int ultimos=0;
+int fase[MAX_PARTICIPANTES];
+int adelantados=0;
+
+static void vueltas(int yo, int n){
+	int i, j;
+
+	for (i=0; i<TOT_VUELTAS; i++){
+		fase[yo]=i;
+		if (esperar_barrera(bar)==1)
+			ultimos++;
+		/* nadie puede seguir en una vuelta anterior */
+		for (j=0; j<n; j++)
+			if (fase[j]<i)
+				adelantados++;
+	}
+}
+
+static int num_participantes;
+
+void participante(void *arg){
+
+	vueltas((long)arg, num_participantes);
+}
+
+int main(){
+	int tam[]={2, 4, MAX_PARTICIPANTES};
+	int hilos[MAX_PARTICIPANTES];
+	int i, k, n, t0, t1, estado;
+
+	printf("bench_barrera: comienza\n");
+	for (k=0; k<sizeof(tam)/sizeof(tam[0]); k++){
+		n=num_participantes=tam[k];
+		ultimos=adelantados=0;
+		for (i=0; i<n; i++)
+			fase[i]=0;
+		if ((bar=crear_barrera("bench", n))<0)
+			printf("error creando barrera. NO DEBE APARECER\n");
+
+		t0=obtener_tiempo();
+		for (i=1; i<n; i++)
+			hilos[i]=crear_hilo(participante, (void *)(long)i);
+		vueltas(0, n);
+		t1=obtener_tiempo();
+		for (i=1; i<n; i++)
+			esperar_proceso(hilos[i], &estado);
+
+		if (t1==t0)
+			t1=t0+1;
+		printf("bench_barrera: %d participantes: %d vueltas en %d ms (%d us/vuelta)\n",
+			n, TOT_VUELTAS, t1-t0, (int)((long)(t1-t0)*1000/TOT_VUELTAS));
+		if (ultimos!=TOT_VUELTAS || adelantados!=0)
+			printf("%d ultimos y %d adelantados. NO DEBE APARECER\n",
+				ultimos, adelantados);
+		cerrar_barrera(bar);
+	}
+
+	if (crear_barrera("mala", 0)!=-1 || esperar_barrera(99)!=-1)
+		printf("barrera sin participantes o inexistente sin error. NO DEBE APARECER\n");
+	printf("bench_barrera: termina\n");
+	return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * usuario/bench_lock.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que mide cuántas parejas lock/unlock por segundo se
+ * hacen sobre un mutex que nadie más usa: entrando siempre en el núcleo
+ * (lock_directo/unlock_directo) y con lock/unlock, que lo cogen y lo
+ * sueltan en la biblioteca. Comprueba también que la recursividad y los
+ * errores siguen igual con los dos caminos.
+ */
+
+#include "servicios.h"
+
+#define TOT_PAREJAS 1000000	/* parejas de cada medida */
+
+static void informe(char *nombre, int parejas, int ms){
+	if (ms==0)
+		ms=1;
+	printf("bench_lock: %s: %d parejas en %d ms (%d parejas/s)\n",
+		nombre, parejas, ms, (int)((long)parejas*1000/ms));
+}
+
+int main(){
+	int i, t0, t1, m, r;
+
+	printf("bench_lock: comienza\n");
+	m=crear_mutex("bench", NO_RECURSIVO);
+	r=crear_mutex("rbench", RECURSIVO);
+
+	t0=obtener_tiempo();
+	for (i=0; i<TOT_PAREJAS; i++){
+		lock_directo(m);
+		unlock_directo(m);
+	}
+	t1=obtener_tiempo();
+	informe("entrando en el nucleo", TOT_PAREJAS, t1-t0);
+
+	t0=obtener_tiempo();
+	for (i=0; i<TOT_PAREJAS; i++){
+		lock(m);
+		unlock(m);
+	}
+	t1=obtener_tiempo();
+	informe("en la biblioteca", TOT_PAREJAS, t1-t0);
+
+	/* los dos caminos se pueden mezclar */
+	lock(m);
+	if (lock(m)!=-2)
+		printf("segundo lock de no recursivo sin error. NO DEBE APARECER\n");
+	if (unlock_directo(m)<0 || unlock(m)!=-2)
+		printf("unlock erroneo. NO DEBE APARECER\n");
+
+	lock(r);
+	lock_directo(r);
+	lock(r);
+	if (unlock(r)<0 || unlock_directo(r)<0 || unlock(r)<0 || unlock(r)!=-2)
+		printf("recursividad erronea. NO DEBE APARECER\n");
+
+	/* lo deja bloqueado: lo suelta el cierre implicito al terminar */
+	lock(m);
+	printf("bench_lock: termina\n");
+	return 0;
+}
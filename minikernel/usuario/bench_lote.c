@@ -0,0 +1,69 @@
+/*
+ * usuario/bench_lote.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que mide cuántas llamadas por segundo se hacen en
+ * un bucle de obtener_id_pr/escribir, una a una y agrupadas con
+ * llamsis_lote. escribir usa longitud 0 para medir solo el coste de
+ * entrar en el núcleo y no el del terminal.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+#define TOT_LLAMADAS 200000	/* llamadas de cada medida */
+#define TAM_LOTE 32		/* llamadas por lote (par) */
+
+static void informe(char *nombre, int llamadas, int ms){
+	if (ms==0)
+		ms=1;
+	printf("bench_lote: %s: %d llamadas en %d ms (%d llamadas/s)\n",
+		nombre, llamadas, ms, (int)((long)llamadas*1000/ms));
+}
+
+int main(){
+	op_lote lote[TAM_LOTE];
+	int i, j, t0, t1;
+	char c='x';
+
+	printf("bench_lote: comienza\n");
+
+	/* una llamada por entrada en el núcleo */
+	t0=obtener_tiempo();
+	for (i=0; i<TOT_LLAMADAS; i+=2){
+		obtener_id_pr();
+		escribir(&c, 0);
+	}
+	t1=obtener_tiempo();
+	informe("una a una", TOT_LLAMADAS, t1-t0);
+
+	/* el mismo bucle en lotes de TAM_LOTE llamadas */
+	for (j=0; j<TAM_LOTE; j+=2){
+		lote[j].servicio=OBTENER_ID;
+		lote[j+1].servicio=ESCRIBIR;
+		lote[j+1].args[0]=(long)&c;
+		lote[j+1].args[1]=0;
+	}
+	t0=obtener_tiempo();
+	for (i=0; i<TOT_LLAMADAS; i+=TAM_LOTE)
+		if (llamsis_lote(lote, TAM_LOTE)!=TAM_LOTE)
+			printf("error en llamsis_lote. NO DEBE APARECER\n");
+	t1=obtener_tiempo();
+	informe("en lotes", TOT_LLAMADAS, t1-t0);
+
+	/* el lote se detiene en la llamada que bloquearía */
+	lote[0].servicio=OBTENER_ID;
+	lote[1].servicio=DORMIR;
+	lote[1].args[0]=1;
+	if (llamsis_lote(lote, 2)==1)
+		printf("bench_lote: lote detenido antes de dormir. DEBE APARECER\n");
+
+	printf("bench_lote: termina\n");
+	return 0;
+}
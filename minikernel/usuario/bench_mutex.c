@@ -0,0 +1,59 @@
+/*
+ * usuario/bench_mutex.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que mide cuántas parejas abrir_mutex/cerrar_mutex
+ * y crear_mutex/cerrar_mutex por segundo hace el núcleo. Para ver cómo
+ * escala con el tamaño de la tabla de mutex del sistema, se compila el
+ * núcleo con otro límite (p.ej. make NUM_MUTEX=4096 en minikernel).
+ */
+
+#include "servicios.h"
+
+#define TOT_PAREJAS 100000	/* parejas de llamadas de cada medida */
+
+static void informe(char *nombre, int parejas, int ms){
+	if (ms==0)
+		ms=1;
+	printf("bench_mutex: %s: %d parejas en %d ms (%d parejas/s)\n",
+		nombre, parejas, ms, (int)((long)parejas*1000/ms));
+}
+
+int main(){
+	int i, t0, t1, desc, fijo;
+
+	printf("bench_mutex: comienza\n");
+
+	/* lo mantiene abierto para que abrir lo encuentre */
+	if ((fijo=crear_mutex("fijo", NO_RECURSIVO))<0)
+		printf("error creando fijo. NO DEBE APARECER\n");
+
+	t0=obtener_tiempo();
+	for (i=0; i<TOT_PAREJAS; i++){
+		if ((desc=abrir_mutex("fijo"))<0)
+			printf("error abriendo fijo. NO DEBE APARECER\n");
+		cerrar_mutex(desc);
+	}
+	t1=obtener_tiempo();
+	informe("abrir/cerrar", TOT_PAREJAS, t1-t0);
+
+	/* el ultimo cierre lo destruye: se crea cada vez */
+	t0=obtener_tiempo();
+	for (i=0; i<TOT_PAREJAS; i++){
+		if ((desc=crear_mutex("temp", NO_RECURSIVO))<0)
+			printf("error creando temp. NO DEBE APARECER\n");
+		cerrar_mutex(desc);
+	}
+	t1=obtener_tiempo();
+	informe("crear/cerrar", TOT_PAREJAS, t1-t0);
+
+	cerrar_mutex(fijo);
+	printf("bench_mutex: termina\n");
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * usuario/bench_politica.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que mide cuántos lock/unlock por segundo se hacen
+ * sobre un mutex que se disputan el proceso y varios hilos suyos, con cada
+ * una de las políticas de unlock (ver fijar_politica_mutex). Cada uno
+ * trabaja un rato con el mutex cogido y otro sin él. Para ver si la
+ * política es justa, muestra también cuánto tarda en acabar el último
+ * después del primero.
+ */
+
+#include "servicios.h"
+
+#define NUM_PARTICIPANTES 4	/* el proceso y 3 hilos */
+#define TOT_VUELTAS 20000	/* lock/unlock de cada participante */
+#define TRABAJO 2000		/* iteraciones dentro y fuera del mutex */
+
+int m;
+int fin[NUM_PARTICIPANTES];
+
+static void trabajar(){
+	volatile int i;
+
+	for (i=0; i<TRABAJO; i++)
+		;
+}
+
+static void vueltas(int yo){
+	int i;
+
+	for (i=0; i<TOT_VUELTAS; i++){
+		lock(m);
+		trabajar();
+		unlock(m);
+		trabajar();
+	}
+	fin[yo]=obtener_tiempo();
+}
+
+void participante(void *arg){
+
+	vueltas((long)arg);
+}
+
+int main(){
+	char *nombres[]={"entrega", "competir"};
+	int politicas[]={POLITICA_ENTREGA, POLITICA_COMPETIR};
+	int hilos[NUM_PARTICIPANTES];
+	int i, k, t0, t1, primero, estado;
+
+	printf("bench_politica: comienza\n");
+	for (k=0; k<2; k++){
+		if ((m=crear_mutex("bench", NO_RECURSIVO))<0)
+			printf("error creando mutex. NO DEBE APARECER\n");
+		if (fijar_politica_mutex(m, politicas[k])!=POLITICA_ENTREGA)
+			printf("error fijando la politica. NO DEBE APARECER\n");
+
+		t0=obtener_tiempo();
+		for (i=1; i<NUM_PARTICIPANTES; i++)
+			hilos[i]=crear_hilo(participante, (void *)(long)i);
+		vueltas(0);
+		for (i=1; i<NUM_PARTICIPANTES; i++)
+			esperar_proceso(hilos[i], &estado);
+		t1=obtener_tiempo();
+
+		primero=t1;
+		for (i=0; i<NUM_PARTICIPANTES; i++)
+			if (fin[i]<primero)
+				primero=fin[i];
+		if (t1==t0)
+			t1=t0+1;
+		printf("bench_politica: %s: %d lock en %d ms (%d lock/s), el ultimo acaba %d ms despues del primero\n",
+			nombres[k], NUM_PARTICIPANTES*TOT_VUELTAS, t1-t0,
+			(int)((long)NUM_PARTICIPANTES*TOT_VUELTAS*1000/(t1-t0)),
+			t1-primero);
+		cerrar_mutex(m);
+	}
+
+	if (fijar_politica_mutex(99, POLITICA_COMPETIR)!=-1)
+		printf("politica de un mutex inexistente sin error. NO DEBE APARECER\n");
+	printf("bench_politica: termina\n");
+	return 0;
+}
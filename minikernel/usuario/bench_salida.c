@@ -0,0 +1,57 @@
+/*
+ * usuario/bench_salida.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que compara cuántas veces se entra en el núcleo
+ * para escribir las mismas líneas cortas con cada modo del buffer de
+ * salida. Las llamadas ESCRIBIR se cuentan con estad_llamsis.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+#define TOT_LINEAS 100
+#define PRINTF_POR_LINEA 4	/* printf cortos por cada línea */
+
+static char *nombres[]={"con buffer de linea", "con buffer completo",
+	"sin buffer"};
+
+/* devuelve las llamadas ESCRIBIR que ha hecho el proceso desde la última vez */
+static int traps_escribir(){
+	estad_servicio v[NSERVICIOS];
+
+	estad_llamsis(obtener_id_pr(), v, NSERVICIOS, 1);
+	return v[ESCRIBIR].llamadas;
+}
+
+int main(){
+	int modo, i, traps[3], t0, ms[3];
+
+	for (modo=BUFFER_LINEA; modo<=SIN_BUFFER; modo++){
+		fijar_buffer(modo);
+		traps_escribir();
+		t0=obtener_tiempo();
+		for (i=0; i<TOT_LINEAS; i++){
+			printf("bench_salida: ");
+			printf("linea %d ", i);
+			printf("modo %d", modo);
+			printf("\n");
+		}
+		vaciar_salida();
+		ms[modo]=obtener_tiempo()-t0;
+		traps[modo]=traps_escribir();
+	}
+
+	fijar_buffer(BUFFER_LINEA);
+	for (modo=BUFFER_LINEA; modo<=SIN_BUFFER; modo++)
+		printf("bench_salida: %s: %d printf, %d llamadas ESCRIBIR en %d ms\n",
+			nombres[modo], TOT_LINEAS*PRINTF_POR_LINEA,
+			traps[modo], ms[modo]);
+	return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * usuario/dmesg.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que muestra el contenido del registro del nucleo
+ */
+
+#include "servicios.h"
+
+#define TAM_BUF 8192	/* como TAM_BUF_LOG del nucleo */
+
+static char buf[TAM_BUF];
+
+int main(){
+	int n;
+
+	n=leer_klog(buf, TAM_BUF);
+	printf("dmesg: %d bytes en el registro del nucleo\n", n);
+	escribir(buf, n);
+	return 0;
+}
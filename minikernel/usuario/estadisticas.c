@@ -0,0 +1,65 @@
+/*
+ * usuario/estadisticas.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que muestra las estadisticas de las llamadas al
+ * sistema: numero de llamadas, errores, latencia media y maxima e
+ * histograma de latencias, en total y por proceso. Si recibe algun
+ * argumento (crear_proceso_ext) las pone a cero despues de mostrarlas.
+ */
+
+#include "servicios.h"
+#include "llamsis.h"
+
+static char *nombres[]=NOMBRES_SERVICIOS;
+
+/* no compila si falta el nombre de algun servicio en llamsis.h */
+typedef char nombres_completos[(sizeof(nombres)/sizeof(nombres[0])==NSERVICIOS) ? 1 : -1];
+
+/* muestra las filas de los servicios usados, si hay alguno */
+static void mostrar(int proc, estad_servicio *v, int n){
+	int i, j, usados=0;
+
+	for (i=0; i<n; i++)
+		usados+=(v[i].llamadas>0);
+	if (usados==0)
+		return;
+
+	if (proc==-1)
+		printf("total:\n");
+	else
+		printf("proceso %d:\n", proc);
+	for (i=0; i<n; i++){
+		if (v[i].llamadas==0)
+			continue;
+		printf("  %-18s %8d %6d %6d %6d  ",
+			nombres[i], v[i].llamadas,
+			v[i].errores,
+			v[i].lat_total/v[i].llamadas, v[i].lat_max);
+		for (j=0; j<NUM_CUBOS_LAT; j++)
+			printf(" %d", v[i].hist[j]);
+		printf("\n");
+	}
+}
+
+int main(){
+	estad_servicio v[NSERVICIOS];
+	int argc, proc, n;
+	char **argv;
+
+	obtener_args(&argc, &argv);
+
+	printf("estadisticas: servicio llamadas errores media(ms) max(ms)  histograma <1 <2 <4 ... ms\n");
+	n=estad_llamsis(-1, v, NSERVICIOS, argc>0);
+	mostrar(-1, v, n);
+
+	for (proc=0; (n=estad_llamsis(proc, v, NSERVICIOS, argc>0))>=0; proc++)
+		mostrar(proc, v, n);
+	return 0;
+}
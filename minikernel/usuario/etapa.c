@@ -0,0 +1,32 @@
+/*
+ * usuario/etapa.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que forma parte de la prueba de la llamada ejecutar.
+ * Se ejecuta sobre el mismo proceso que prueba_ejecutar y usa el mutex
+ * que este dejó abierto en el descriptor 0.
+ */
+
+#include "servicios.h"
+
+int main(){
+
+	printf("etapa (%d): comienza con el mismo identificador\n",
+		obtener_id_pr());
+
+	if (lock(0)<0)
+		printf("error en lock del mutex conservado. NO DEBE APARECER\n");
+
+	if (unlock(0)<0)
+		printf("error en unlock del mutex conservado. NO DEBE APARECER\n");
+
+	printf("etapa (%d): termina con estado 5\n", obtener_id_pr());
+	salir(5);
+	return 0;
+}
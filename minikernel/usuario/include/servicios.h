@@ -19,26 +19,249 @@
 #ifndef SERVICIOS_H
 #define SERVICIOS_H
 
+#include "const.h"	/* constantes del nucleo (NUM_MUT_PROC...) */
+
 /* Evita el uso del printf de la bilioteca est�ndar */
 #define printf escribirf
 
 #define RECURSIVO 1
 #define NO_RECURSIVO 0
 
+/* Politicas de crear_rwlock. Deben coincidir con las definiciones de
+   minikernel/include/kernel.h */
+#define PREF_ESCRITOR 0		/* un lector espera si espera un escritor */
+#define PREF_LECTOR 1		/* solo si hay un escritor dentro */
+
+/* Prioridades de los procesos (mayor valor, mas prioridad) */
+#define PRIO_MIN 1
+#define PRIO_DEFECTO 10
+#define PRIO_MAX 20
+
+/* Atributos de crear_proceso_ext. Un campo a 0 indica valor por defecto */
+typedef struct {
+	int tam_pila;		/* tamano de la pila en bytes */
+	int prioridad;		/* prioridad inicial (PRIO_MIN..PRIO_MAX) */
+	int rodaja;		/* ticks por rodaja */
+	int argc;		/* numero de argumentos */
+	char **argv;		/* argumentos que se copian en la pila */
+} atrib_proceso;
+
+/* Limites de recursos de un proceso (0 indica sin limite), que heredan
+   los procesos que crea. Solo se pueden reducir. Deben coincidir con la
+   definicion de minikernel/include/kernel.h */
+typedef struct {
+	int max_ticks;		/* ticks de UCP que puede consumir */
+	int max_hijos;		/* hijos sin recoger que puede tener */
+	int max_mutex;		/* descriptores de mutex abiertos */
+	int max_pila;		/* tamano de pila de los procesos que crea */
+} limites_proceso;
+
+/* Estadisticas del terminal que devuelve estad_terminal. Deben coincidir
+   con la definicion de minikernel/include/kernel.h */
+typedef struct {
+	unsigned int recibidos;		/* caracteres guardados en el buffer */
+	unsigned int leidos;		/* caracteres entregados a los lectores */
+	unsigned int perdidos;		/* caracteres perdidos (buffer lleno) */
+	unsigned int pendientes;	/* caracteres en el buffer ahora */
+} estad_term;
+
+/* Palabra de un mutex que comparten el nucleo y la biblioteca: lock y
+   unlock la cambian sin entrar en el nucleo si nadie espera. estado vale
+   0 si esta libre y, si no, el id del dueno mas 1, con MUTEX_ESPERAS si
+   hay algo esperando en el nucleo. Debe coincidir con la definicion de
+   minikernel/include/kernel.h */
+#define MUTEX_ESPERAS 0x40000000
+#define MUTEX_DUENO(estado) ((estado) & ~MUTEX_ESPERAS)
+
+typedef struct {
+	volatile int estado;	/* 0 o id del dueno + 1 (| MUTEX_ESPERAS) */
+	int tipo;		/* RECURSIVO o NO_RECURSIVO */
+	int bloqueos;		/* veces que lo tiene bloqueado su dueno */
+} palabra_mutex;
+
+/* Palabras de los mutex abiertos por el proceso, tal como las publica el
+   nucleo: por cada bloque de DESC_POR_BLOQUE descriptores, el vector de
+   sus palabras (NULL en los que no son mutex abiertos). Deben coincidir
+   con las definiciones de minikernel/include/kernel.h */
+#define DESC_POR_BLOQUE 8
+
+typedef struct {
+	int num_bloques;		/* bloques reservados */
+	palabra_mutex ***bloques;	/* palabras de cada bloque */
+} tabla_palabras;
+
+/* Conjunto de eventos de esperar_eventos: un bit por descriptor de mutex
+   (listo si lock no bloquearia) y otro para el terminal (hay caracteres).
+   Deben coincidir con las definiciones de minikernel/include/kernel.h */
+#define EV_MUTEX(desc) (1<<(desc))
+#define EV_TERMINAL (1<<NUM_MUT_PROC)
+
+/* Estado de terminacion de un proceso que supera un limite */
+#define FIN_LIMITE_CPU -10
+#define FIN_LIMITE_HIJOS -11
+#define FIN_LIMITE_MUTEX -12
+#define FIN_LIMITE_PILA -13
+
+/* Entrada del vector de llamsis_lote: numero de llamada, sus parametros
+   y el resultado que deja el nucleo */
+#define NARGS_LOTE 5
+
+typedef struct {
+	int servicio;
+	long args[NARGS_LOTE];
+	long resultado;
+} op_lote;
+
+/* Anillos de envio y de finalizacion de operaciones asincronas. Deben
+   coincidir con la definicion de minikernel/include/kernel.h */
+#define TAM_ANILLO 16
+
+#define OP_LOCK 0		/* arg1: descriptor del mutex */
+#define OP_DORMIR 1		/* arg1: segundos */
+#define OP_LEER_CAR 2		/* resultado: caracter leido */
+#define OP_ESCRIBIR 3		/* arg1: texto, arg2: longitud */
+
+typedef struct {
+	int op;
+	long arg1;
+	long arg2;
+	long dato;		/* se devuelve tal cual en la finalizacion */
+} peticion_anillo;
+
+typedef struct {
+	long dato;
+	long resultado;
+} fin_anillo;
+
+typedef struct {
+	volatile unsigned int cabeza;	/* la avanza el nucleo */
+	volatile unsigned int cola;	/* la avanza el proceso */
+	peticion_anillo entradas[TAM_ANILLO];
+} anillo_envio;
+
+typedef struct {
+	volatile unsigned int cabeza;	/* la avanza el proceso */
+	volatile unsigned int cola;	/* la avanza el nucleo */
+	fin_anillo entradas[TAM_ANILLO];
+} anillo_fin;
+
+/* Estadisticas de uso de una llamada al sistema. Deben coincidir con la
+   definicion de minikernel/include/kernel.h. El cubo i del histograma
+   cuenta las llamadas que tardan menos de 2^i ms (el ultimo, el resto) */
+#define NUM_CUBOS_LAT 8
+
+typedef struct {
+	unsigned int llamadas;
+	unsigned int errores;
+	unsigned int lat_total;		/* ms */
+	unsigned int lat_max;		/* ms */
+	unsigned int hist[NUM_CUBOS_LAT];
+} estad_servicio;
+
+/* Politicas de un mutex al soltarlo si hay procesos esperando (ver
+   fijar_politica_mutex): entregarlo al primero (por defecto) o dejarlo
+   libre y despertar al primero para que compita por el. Deben coincidir
+   con las definiciones de minikernel/include/kernel.h */
+#define POLITICA_ENTREGA 0
+#define POLITICA_COMPETIR 1
+
+/* Estadisticas de contencion de un mutex (lockstat), en ms. Solo se
+   recogen mientras estan activas, y entonces lock y unlock entran siempre
+   en el nucleo. Deben coincidir con las definiciones de
+   minikernel/include/kernel.h */
+#define LOCKSTAT_ACTIVAR 1	/* empieza a recogerlas */
+#define LOCKSTAT_PARAR 2	/* deja de recogerlas */
+#define LOCKSTAT_REINICIAR 4	/* las pone a cero */
+
+typedef struct {
+	char nombre[MAX_NOM_MUT+1];
+	unsigned int adquisiciones;
+	unsigned int contendidas;	/* las que tuvieron que esperar */
+	unsigned int reentradas;	/* locks de un recursivo ya cogido */
+	unsigned int espera_total;
+	unsigned int espera_max;
+	unsigned int retencion_total;
+	unsigned int retencion_max;
+	unsigned int max_esperando;
+} estad_mutex;
+
+/* Modos del buffer de salida de escribir y escribirf (ver fijar_buffer) */
+#define BUFFER_LINEA 0		/* se vacia con cada fin de linea */
+#define BUFFER_COMPLETO 1	/* se vacia cuando se llena */
+#define SIN_BUFFER 2
+
 /* Funcion de biblioteca */
 int escribirf(const char *formato, ...);
 
+/* Funciones de biblioteca de la salida con buffer. Tambien se vacia al
+   terminar el proceso (terminar_proceso, salir o volver de main) */
+int fijar_buffer(int modo);
+int vaciar_salida();
+
 /* Llamadas al sistema proporcionadas */
 int crear_proceso(char *prog);
 int terminar_proceso();
-int escribir(char *texto, unsigned int longi);
+int escribir(char *texto, unsigned int longi);	/* con buffer */
+int escribir_directo(char *texto, unsigned int longi);	/* sin buffer */
 int obtener_id_pr();
 int dormir(unsigned int segs);
 int crear_mutex(char *nombre, int tipo);
 int abrir_mutex(char *nombre);
-int lock(unsigned int mutexid);
-int unlock(unsigned int mutexid);
+int lock(unsigned int mutexid);		/* sin entrar en el nucleo */
+int unlock(unsigned int mutexid);	/* si nadie espera */
+int trylock(unsigned int mutexid);	/* -3 si esta ocupado */
+int lock_timeout(unsigned int mutexid, int ticks);	/* -3 si vencen */
+int lock_directo(unsigned int mutexid);		/* entrando siempre */
+int unlock_directo(unsigned int mutexid);
 int cerrar_mutex(unsigned int mutexid);
+int fijar_politica_mutex(unsigned int mutexid, int politica);	/* la que tenia */
+int crear_rwlock(char *nombre, int preferencia);
+int abrir_rwlock(char *nombre);
+int lock_lectura(unsigned int rwid);
+int lock_escritura(unsigned int rwid);
+int unlock_rw(unsigned int rwid);	/* la escritura o una lectura */
+int cerrar_rwlock(unsigned int rwid);
+int crear_semaforo(char *nombre, int valor);
+int abrir_semaforo(char *nombre);
+int sem_bajar(unsigned int semid);
+int sem_subir(unsigned int semid);
+int sem_subir_n(unsigned int semid, int n);	/* n unidades de una vez */
+int cerrar_semaforo(unsigned int semid);
+int crear_condicion(char *nombre);
+int abrir_condicion(char *nombre);
+int cond_wait(unsigned int condid, unsigned int mutexid);
+int cond_signal(unsigned int condid);		/* devuelven cuantos */
+int cond_broadcast(unsigned int condid);	/* dejan de esperar */
+int cerrar_condicion(unsigned int condid);
+int crear_barrera(char *nombre, int participantes);
+int abrir_barrera(char *nombre);
+int esperar_barrera(unsigned int barid);	/* 1 al ultimo en llegar */
+int cerrar_barrera(unsigned int barid);
+int estad_cerrojos(estad_mutex *v, int n, int modo);	/* LOCKSTAT_... */
+int salir(int estado);	/* como terminar_proceso pero fijando el estado */
+int esperar_proceso(int pid, int *estado);
+int ejecutar(char *prog, int conservar_mutex);
+int crear_hilo(void (*funcion)(void *), void *arg);
+int crear_proceso_ext(char *prog, atrib_proceso *atrib);
+int obtener_args(int *argc, char ***argv);
+int llamsis_lote(op_lote *ops, int n);
+int obtener_tiempo();
+int registrar_anillos(anillo_envio *envio, anillo_fin *fin);
+int enviar_anillo(int min_fin);
+int estad_llamsis(int proc, estad_servicio *v, int n, int reiniciar);
+int crear_proceso_esp(char *prog, atrib_proceso *atrib, int segs);	/* -4: recoger hijos */
+int fijar_limites(limites_proceso *limites);
+int obtener_limites(limites_proceso *limites);	/* devuelve ticks de UCP */
+int leer_klog(char *buf, int n);
+int leer_caracter();
+int leer_linea(char *buf, int n);	/* hasta fin de linea o n-1 */
+int leer(char *buf, int n);		/* lo que haya, al menos 1 */
+int estad_terminal(estad_term *estad);	/* devuelve caracteres perdidos */
+int esperar_eventos(int conjunto, int timeout);	/* timeout en ms */
+
+/* Funciones de biblioteca para manejar los anillos */
+int preparar_op(anillo_envio *envio, int op, long arg1, long arg2, long dato);
+int recoger_fin(anillo_fin *fin, fin_anillo *res);
 
 #endif /* SERVICIOS_H */
 
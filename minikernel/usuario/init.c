@@ -24,6 +24,7 @@
 #include "servicios.h"
 
 int main(){
+	int pid, estado;
 
 	printf("init: comienza\n");
 
@@ -86,6 +87,130 @@ ALGO COMENTE ESTA PARTE Y DESCOMENTE LA PRUEBA CORRESPONDIENTE */
 		printf("Error creando prueba_term\n");
 */
 
+/* PRUEBA DE LA LLAMADA ESPERAR_PROCESO
+	if (crear_proceso("prueba_esperar")<0)
+		printf("Error creando prueba_esperar\n");
+*/
+
+/* PRUEBA DE LA LLAMADA EJECUTAR
+	if (crear_proceso("prueba_ejecutar")<0)
+		printf("Error creando prueba_ejecutar\n");
+*/
+
+/* PRUEBA DE LA LLAMADA CREAR_HILO
+	if (crear_proceso("prueba_hilos")<0)
+		printf("Error creando prueba_hilos\n");
+*/
+
+/* PRUEBA DE LA LLAMADA CREAR_PROCESO_EXT
+	if (crear_proceso("prueba_atributos")<0)
+		printf("Error creando prueba_atributos\n");
+*/
+
+/* MEDIDA DE LA LLAMADA LLAMSIS_LOTE
+	if (crear_proceso("bench_lote")<0)
+		printf("Error creando bench_lote\n");
+*/
+
+/* PRUEBA DE LAS OPERACIONES ASINCRONAS
+	if (crear_proceso("prueba_anillo")<0)
+		printf("Error creando prueba_anillo\n");
+*/
+
+/* PRUEBA DE CREAR_PROCESO_ESP CON LA TABLA DE PROCESOS LLENA
+	if (crear_proceso("prueba_admision")<0)
+		printf("Error creando prueba_admision\n");
+*/
+
+/* PRUEBA DE LOS LIMITES DE RECURSOS
+	if (crear_proceso("prueba_limites")<0)
+		printf("Error creando prueba_limites\n");
+*/
+
+/* MEDIDA DE LA SALIDA CON BUFFER
+	if (crear_proceso("bench_salida")<0)
+		printf("Error creando bench_salida\n");
+*/
+
+/* PRUEBA DE LA COLA DE SALIDA DEL NUCLEO
+	if (crear_proceso("prueba_salida")<0)
+		printf("Error creando prueba_salida\n");
+*/
+
+/* PRUEBA DE LAS LECTURAS DEL TERMINAL
+	if (crear_proceso("prueba_leer")<0)
+		printf("Error creando prueba_leer\n");
+*/
+
+/* PRUEBA DE LA ESPERA DE VARIOS EVENTOS
+	if (crear_proceso("prueba_eventos")<0)
+		printf("Error creando prueba_eventos\n");
+*/
+
+/* MEDIDA DE LA APERTURA Y CIERRE DE MUTEX
+	if (crear_proceso("bench_mutex")<0)
+		printf("Error creando bench_mutex\n");
+*/
+
+/* MEDIDA DE LOCK/UNLOCK SIN CONTENCION
+	if (crear_proceso("bench_lock")<0)
+		printf("Error creando bench_lock\n");
+*/
+
+/* PRUEBA DE TRYLOCK Y LOCK_TIMEOUT
+	if (crear_proceso("prueba_trylock")<0)
+		printf("Error creando prueba_trylock\n");
+*/
+
+/* PRUEBA DE HERENCIA DE PRIORIDAD EN LOS MUTEX
+	if (crear_proceso("prueba_herencia")<0)
+		printf("Error creando prueba_herencia\n");
+*/
+
+/* PRUEBA DE RWLOCKS
+	if (crear_proceso("prueba_rwlock")<0)
+		printf("Error creando prueba_rwlock\n");
+*/
+
+/* PRUEBA DE SEMAFOROS Y VARIABLES CONDICION
+	if (crear_proceso("prueba_semaforos")<0)
+		printf("Error creando prueba_semaforos\n");
+*/
+
+/* MEDIDA DE LA VUELTA DE BARRERA
+	if (crear_proceso("bench_barrera")<0)
+		printf("Error creando bench_barrera\n");
+*/
+
+/* PRUEBA DE LA TABLA DE DESCRIPTORES DE MUTEX
+	if (crear_proceso("prueba_descriptores")<0)
+		printf("Error creando prueba_descriptores\n");
+*/
+
+/* MEDIDA DE LAS POLITICAS DE UNLOCK CON CONTENCION
+	if (crear_proceso("bench_politica")<0)
+		printf("Error creando bench_politica\n");
+*/
+
+	/* espera a que terminen los procesos creados por init */
+	while ((pid=esperar_proceso(-1, &estado))>=0)
+		printf("init: proceso %d termina con estado %d\n", pid, estado);
+
+/* CONTENIDO DEL REGISTRO DEL NUCLEO
+	if ((pid=crear_proceso("dmesg"))>=0)
+		esperar_proceso(pid, &estado);
+*/
+
+/* ESTADISTICAS DE LAS LLAMADAS AL SISTEMA DE TODOS LOS PROCESOS
+	if ((pid=crear_proceso("estadisticas"))>=0)
+		esperar_proceso(pid, &estado);
+*/
+
+/* MUTEX CON MAS CONTENCION DURANTE prueba_herencia (lockstat)
+	if ((pid=crear_proceso("lockstat"))>=0)
+		esperar_proceso(pid, &estado);
+*/
+
 	printf("init: termina\n");
 	return 0; 
 }
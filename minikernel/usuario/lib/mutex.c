@@ -0,0 +1,104 @@
+/*
+ *  usuario/lib/mutex.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ *
+ * Fichero que contiene lock y unlock. Cada mutex tiene una palabra que
+ * comparten el nucleo y la biblioteca: si el mutex esta libre, lock lo
+ * coge con una operacion atomica sin entrar en el nucleo, y unlock lo
+ * suelta igual si nadie espera por el. Solo se entra en el nucleo para
+ * bloquearse, para despertar a quien espera y para devolver los errores.
+ *
+ */
+
+#include "const.h"
+#include "llamsis.h"
+#include "servicios.h"
+
+int *dir_id_proc_actual();	/* de salida.c */
+int llamsis(int llamada, int nargs, ... /* args */);	/* de misc.o */
+
+/* la rellena el nucleo al planificar; 0 si no lo hace (siempre se entra) */
+static tabla_palabras *palabras_proc_actual=0;
+
+/*
+ * La usa el nucleo al cargar el programa para saber donde dejar las
+ * palabras de los mutex del proceso que va a ejecutar (ver
+ * FUNC_PALABRAS_USUARIO en kernel.h)
+ */
+tabla_palabras **dir_palabras_proc_actual(){
+	return &palabras_proc_actual;
+}
+
+static palabra_mutex *palabra(unsigned int mutexid){
+	tabla_palabras *tabla=palabras_proc_actual;
+
+	if (tabla==0 || mutexid/DESC_POR_BLOQUE>=tabla->num_bloques)
+		return 0;
+	return tabla->bloques[mutexid/DESC_POR_BLOQUE][mutexid%DESC_POR_BLOQUE];
+}
+
+/*
+ * Intenta coger el mutex sin entrar en el nucleo: lo consigue si esta
+ * libre o si ya es suyo y es recursivo. Devuelve 1 si lo ha cogido.
+ */
+static int lock_rapido(unsigned int mutexid){
+	palabra_mutex *p=palabra(mutexid);
+	int yo=*dir_id_proc_actual()+1;
+
+	if (p==0 || yo<=0)
+		return 0;
+	/* libre: es suyo en cuanto la operacion atomica lo marca */
+	if (__sync_bool_compare_and_swap(&(p->estado), 0, yo)){
+		p->bloqueos=1;
+		return 1;
+	}
+	if (MUTEX_DUENO(p->estado)==yo && p->tipo==RECURSIVO){
+		p->bloqueos++;
+		return 1;
+	}
+	return 0;
+}
+
+/* si esta ocupado por otro (hay que esperar) o hay error, entran en el
+   nucleo */
+int lock(unsigned int mutexid){
+	if (lock_rapido(mutexid))
+		return 0;
+	return lock_directo(mutexid);
+}
+
+int trylock(unsigned int mutexid){
+	if (lock_rapido(mutexid))
+		return 0;
+	return llamsis(TRYLOCK_MUTEX, 1, (long)mutexid);
+}
+
+int lock_timeout(unsigned int mutexid, int ticks){
+	if (lock_rapido(mutexid))
+		return 0;
+	return llamsis(LOCK_TIMEOUT, 2, (long)mutexid, (long)ticks);
+}
+
+int unlock(unsigned int mutexid){
+	palabra_mutex *p=palabra(mutexid);
+	int yo=*dir_id_proc_actual()+1;
+
+	if (p && yo>0 && MUTEX_DUENO(p->estado)==yo){
+		if (p->bloqueos>1){
+			p->bloqueos--;
+			return 0;
+		}
+		/* falla si alguien ha marcado MUTEX_ESPERAS */
+		if (__sync_bool_compare_and_swap(&(p->estado), yo, 0))
+			return 0;
+	}
+	/* hay que despertar a quien espera o error */
+	return unlock_directo(mutexid);
+}
@@ -0,0 +1,89 @@
+/*
+ *  usuario/lib/salida.c
+ *
+ *  Minikernel. Versi�n 1.0
+ *
+ *  Fernando P�rez Costoya
+ *
+ */
+
+/*
+ *
+ * Fichero que contiene la capa de salida con buffer que usan escribir y
+ * escribirf. Cada proceso tiene su propio buffer, aunque comparta la imagen
+ * con otros (hilos o varias copias del mismo programa): el nucleo deja en
+ * id_proc_actual el id del proceso que va a ejecutar.
+ *
+ */
+
+#include <string.h>
+#include "const.h"
+#include "servicios.h"
+
+#define TAM_BUF_SALIDA 512
+
+struct buffer_salida {
+	int modo;		/* BUFFER_LINEA (por defecto), BUFFER_COMPLETO... */
+	unsigned int usado;	/* bytes pendientes de escribir */
+	char datos[TAM_BUF_SALIDA];
+};
+
+static struct buffer_salida buffers[MAX_PROC];
+
+/* la rellena el nucleo; -1 si no lo hace (se escribe sin buffer) */
+static int id_proc_actual=-1;
+
+/*
+ * La usa el nucleo al cargar el programa para saber donde dejar el id
+ * del proceso que va a ejecutar (ver FUNC_ID_USUARIO en kernel.h)
+ */
+int *dir_id_proc_actual(){
+	return &id_proc_actual;
+}
+
+static struct buffer_salida *buffer_actual(){
+	if (id_proc_actual<0 || id_proc_actual>=MAX_PROC)
+		return 0;
+	return &buffers[id_proc_actual];
+}
+
+int vaciar_salida(){
+	struct buffer_salida *b=buffer_actual();
+	int res=0;
+
+	if (b && b->usado>0){
+		res=escribir_directo(b->datos, b->usado);
+		b->usado=0;
+	}
+	return res;
+}
+
+int fijar_buffer(int modo){
+	struct buffer_salida *b=buffer_actual();
+
+	if (modo!=BUFFER_LINEA && modo!=BUFFER_COMPLETO && modo!=SIN_BUFFER)
+		return -1;
+	if (b==0)
+		return -1;
+	vaciar_salida();
+	b->modo=modo;
+	return 0;
+}
+
+int escribir(char *texto, unsigned int longi){
+	struct buffer_salida *b=buffer_actual();
+
+	if (b==0 || b->modo==SIN_BUFFER)
+		return escribir_directo(texto, longi);
+
+	if (b->usado+longi > TAM_BUF_SALIDA)
+		vaciar_salida();
+	if (longi >= TAM_BUF_SALIDA)
+		return escribir_directo(texto, longi);	/* no cabe entero */
+
+	memcpy(b->datos+b->usado, texto, longi);
+	b->usado+=longi;
+	if (b->modo==BUFFER_LINEA && memchr(texto, '\n', longi))
+		vaciar_salida();
+	return 0;
+}
@@ -37,10 +37,17 @@ int llamsis(int llamada, int nargs, ... /* args */);
 int crear_proceso(char *prog){
 	return llamsis(CREAR_PROCESO, 1, (long)prog);
 }
+/* la rutina de arranque llama a terminar_proceso al volver de main */
 int terminar_proceso(){
-	return llamsis(TERMINAR_PROCESO, 0);
+	vaciar_salida();
+	return llamsis(TERMINAR_PROCESO, 1, 0L);
 }
-int escribir(char *texto, unsigned int longi){
+int salir(int estado){
+	vaciar_salida();
+	return llamsis(TERMINAR_PROCESO, 1, (long)estado);
+}
+/* escribir (con buffer) esta en salida.c */
+int escribir_directo(char *texto, unsigned int longi){
 	return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
 }
 int obtener_id_pr(){
@@ -58,12 +65,196 @@ int crear_mutex(char *nombre, int tipo){
 int abrir_mutex(char *nombre){
    return llamsis(ABRIR_MUTEX, 1,(long)nombre);
 }
-int lock(unsigned int mutexid){
+/* lock y unlock (en mutex.c) solo entran en el nucleo si hace falta */
+int lock_directo(unsigned int mutexid){
    return llamsis(LOCK_MUTEX, 1,(long)mutexid);
 }
-int unlock(unsigned int mutexid){
+int unlock_directo(unsigned int mutexid){
    return llamsis(UNLOCK_MUTEX, 1,(long)mutexid);
 }
 int cerrar_mutex(unsigned int mutexid){
    return llamsis(CERRAR_MUTEX, 1,(long)mutexid);
 }
+int fijar_politica_mutex(unsigned int mutexid, int politica){
+   return llamsis(FIJAR_POLITICA_MUTEX, 2,(long)mutexid, (long)politica);
+}
+int crear_rwlock(char *nombre, int preferencia){
+   return llamsis(CREAR_RWLOCK, 2,(long)nombre, (long)preferencia);
+}
+int abrir_rwlock(char *nombre){
+   return llamsis(ABRIR_RWLOCK, 1,(long)nombre);
+}
+int lock_lectura(unsigned int rwid){
+   return llamsis(LOCK_LECTURA, 1,(long)rwid);
+}
+int lock_escritura(unsigned int rwid){
+   return llamsis(LOCK_ESCRITURA, 1,(long)rwid);
+}
+int unlock_rw(unsigned int rwid){
+   return llamsis(UNLOCK_RW, 1,(long)rwid);
+}
+/* comparten descriptores con los mutex */
+int cerrar_rwlock(unsigned int rwid){
+   return llamsis(CERRAR_MUTEX, 1,(long)rwid);
+}
+int crear_semaforo(char *nombre, int valor){
+   return llamsis(CREAR_SEMAFORO, 2,(long)nombre, (long)valor);
+}
+int abrir_semaforo(char *nombre){
+   return llamsis(ABRIR_SEMAFORO, 1,(long)nombre);
+}
+int sem_bajar(unsigned int semid){
+   return llamsis(SEM_BAJAR, 1,(long)semid);
+}
+int sem_subir(unsigned int semid){
+   return llamsis(SEM_SUBIR, 2,(long)semid, 1L);
+}
+int sem_subir_n(unsigned int semid, int n){
+   return llamsis(SEM_SUBIR, 2,(long)semid, (long)n);
+}
+int cerrar_semaforo(unsigned int semid){
+   return llamsis(CERRAR_MUTEX, 1,(long)semid);
+}
+int crear_condicion(char *nombre){
+   return llamsis(CREAR_CONDICION, 1,(long)nombre);
+}
+int abrir_condicion(char *nombre){
+   return llamsis(ABRIR_CONDICION, 1,(long)nombre);
+}
+int cond_wait(unsigned int condid, unsigned int mutexid){
+   return llamsis(COND_WAIT, 2,(long)condid, (long)mutexid);
+}
+int cond_signal(unsigned int condid){
+   return llamsis(COND_SIGNAL, 1,(long)condid);
+}
+int cond_broadcast(unsigned int condid){
+   return llamsis(COND_BROADCAST, 1,(long)condid);
+}
+int cerrar_condicion(unsigned int condid){
+   return llamsis(CERRAR_MUTEX, 1,(long)condid);
+}
+int crear_barrera(char *nombre, int participantes){
+   return llamsis(CREAR_BARRERA, 2,(long)nombre, (long)participantes);
+}
+int abrir_barrera(char *nombre){
+   return llamsis(ABRIR_BARRERA, 1,(long)nombre);
+}
+int esperar_barrera(unsigned int barid){
+   return llamsis(ESPERAR_BARRERA, 1,(long)barid);
+}
+int cerrar_barrera(unsigned int barid){
+   return llamsis(CERRAR_MUTEX, 1,(long)barid);
+}
+int estad_cerrojos(estad_mutex *v, int n, int modo){
+   return llamsis(ESTAD_CERROJOS, 3,(long)v, (long)n, (long)modo);
+}
+int esperar_proceso(int pid, int *estado){
+   return llamsis(ESPERAR_PROCESO, 2,(long)pid, (long)estado);
+}
+int ejecutar(char *prog, int conservar_mutex){
+   vaciar_salida();	/* el buffer esta en la imagen que se sustituye */
+   return llamsis(EJECUTAR, 2,(long)prog, (long)conservar_mutex);
+}
+
+/*
+ * Punto de entrada de los hilos: obtiene del nucleo la funcion y el
+ * argumento con los que se creo el hilo. Al volver, la rutina de arranque
+ * llama a terminar_proceso como con cualquier programa.
+ */
+static int lanzadera_hilo(){
+	void (*funcion)(void *);
+	void *arg;
+
+	if (llamsis(ARGS_HILO, 2, (long)&funcion, (long)&arg)<0)
+		return -1;
+	funcion(arg);
+	return 0;
+}
+int crear_hilo(void (*funcion)(void *), void *arg){
+   return llamsis(CREAR_HILO, 3, (long)lanzadera_hilo, (long)funcion, (long)arg);
+}
+int crear_proceso_ext(char *prog, atrib_proceso *atrib){
+   return llamsis(CREAR_PROCESO_EXT, 2, (long)prog, (long)atrib);
+}
+int obtener_args(int *argc, char ***argv){
+   return llamsis(OBTENER_ARGS, 2, (long)argc, (long)argv);
+}
+int llamsis_lote(op_lote *ops, int n){
+   return llamsis(LLAMSIS_LOTE, 2, (long)ops, (long)n);
+}
+int obtener_tiempo(){
+   return llamsis(OBTENER_TIEMPO, 0);
+}
+int registrar_anillos(anillo_envio *envio, anillo_fin *fin){
+   return llamsis(REGISTRAR_ANILLOS, 2, (long)envio, (long)fin);
+}
+int enviar_anillo(int min_fin){
+   return llamsis(ENVIAR_ANILLO, 1, (long)min_fin);
+}
+int estad_llamsis(int proc, estad_servicio *v, int n, int reiniciar){
+   return llamsis(ESTAD_LLAMSIS, 4, (long)proc, (long)v, (long)n, (long)reiniciar);
+}
+int crear_proceso_esp(char *prog, atrib_proceso *atrib, int segs){
+   return llamsis(CREAR_PROCESO_ESP, 3, (long)prog, (long)atrib, (long)segs);
+}
+int fijar_limites(limites_proceso *limites){
+   return llamsis(FIJAR_LIMITES, 1, (long)limites);
+}
+int obtener_limites(limites_proceso *limites){
+   return llamsis(OBTENER_LIMITES, 1, (long)limites);
+}
+int leer_klog(char *buf, int n){
+   return llamsis(LEER_KLOG, 2, (long)buf, (long)n);
+}
+
+/* antes de esperar al terminal se vacia la salida (p.ej. una pregunta) */
+int leer_caracter(){
+   vaciar_salida();
+   return llamsis(LEER_CARACTER, 0);
+}
+int leer_linea(char *buf, int n){
+   vaciar_salida();
+   return llamsis(LEER_LINEA, 2, (long)buf, (long)n);
+}
+int leer(char *buf, int n){
+   vaciar_salida();
+   return llamsis(LEER, 2, (long)buf, (long)n);
+}
+int estad_terminal(estad_term *estad){
+   return llamsis(ESTAD_TERMINAL, 1, (long)estad);
+}
+int esperar_eventos(int conjunto, int timeout){
+   vaciar_salida();
+   return llamsis(ESPERAR_EVENTOS, 2, (long)conjunto, (long)timeout);
+}
+
+/*
+ * Anade una operacion al anillo de envio. No se pone en marcha hasta la
+ * siguiente llamada a enviar_anillo. Devuelve -1 si el anillo esta lleno.
+ */
+int preparar_op(anillo_envio *envio, int op, long arg1, long arg2, long dato){
+	peticion_anillo *p;
+
+	if (envio->cola - envio->cabeza >= TAM_ANILLO)
+		return -1;
+	p=&(envio->entradas[envio->cola % TAM_ANILLO]);
+	p->op=op;
+	p->arg1=arg1;
+	p->arg2=arg2;
+	p->dato=dato;
+	envio->cola++;
+	return 0;
+}
+
+/*
+ * Saca la finalizacion mas antigua del anillo de finalizacion.
+ * Devuelve 0 si no hay ninguna.
+ */
+int recoger_fin(anillo_fin *fin, fin_anillo *res){
+
+	if (fin->cabeza == fin->cola)
+		return 0;
+	*res=fin->entradas[fin->cabeza % TAM_ANILLO];
+	fin->cabeza++;
+	return 1;
+}
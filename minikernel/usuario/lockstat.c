@@ -0,0 +1,82 @@
+/*
+ * usuario/lockstat.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que muestra los mutex con más contención mientras
+ * se ejecuta otro programa: el que recibe como argumento
+ * (crear_proceso_ext) o, si no recibe ninguno, prueba_herencia. Activa
+ * lockstat, ejecuta el programa, espera a que termine y lista los mutex
+ * ordenados por los lock que tuvieron que esperar y, a igualdad, por el
+ * tiempo esperado. Los tiempos son medias y máximos en ms.
+ */
+
+#include "servicios.h"
+
+#define MAX_ESTAD 64	/* mutex que se recogen */
+#define MAX_LISTA 10	/* mutex que se muestran */
+
+/* mas contendido primero */
+static int antes(estad_mutex *a, estad_mutex *b){
+	if (a->contendidas!=b->contendidas)
+		return a->contendidas > b->contendidas;
+	return a->espera_total > b->espera_total;
+}
+
+static void ordenar(estad_mutex *v, int n){
+	estad_mutex e;
+	int i, j;
+
+	for (i=1; i<n; i++){
+		e=v[i];
+		for (j=i; j>0 && antes(&e, &v[j-1]); j--)
+			v[j]=v[j-1];
+		v[j]=e;
+	}
+}
+
+static unsigned int media(unsigned int total, unsigned int n){
+	return n ? total/n : 0;
+}
+
+int main(){
+	estad_mutex v[MAX_ESTAD];
+	char *prog="prueba_herencia";
+	int argc, pid, estado, n, i;
+	char **argv;
+
+	obtener_args(&argc, &argv);
+	if (argc>0)
+		prog=argv[0];
+
+	estad_cerrojos(0, 0, LOCKSTAT_ACTIVAR | LOCKSTAT_REINICIAR);
+	if ((pid=crear_proceso(prog))<0){
+		estad_cerrojos(0, 0, LOCKSTAT_PARAR);
+		printf("lockstat: error creando %s\n", prog);
+		return 1;
+	}
+	esperar_proceso(pid, &estado);
+	n=estad_cerrojos(v, MAX_ESTAD, LOCKSTAT_PARAR);
+	ordenar(v, n);
+
+	printf("lockstat: %s termina con estado %d; %d mutex usados\n",
+		prog, estado, n);
+	printf("lockstat: %-8s %6s %6s %4s %6s %6s %6s %6s %5s %5s\n",
+		"mutex", "adq", "cont", "%", "esp", "espmax", "ret", "retmax",
+		"cola", "reent");
+	for (i=0; i<n && i<MAX_LISTA; i++)
+		printf("lockstat: %-8s %6d %6d %4d %6d %6d %6d %6d %5d %5d\n",
+			v[i].nombre, v[i].adquisiciones, v[i].contendidas,
+			media(100*v[i].contendidas, v[i].adquisiciones),
+			media(v[i].espera_total, v[i].contendidas),
+			v[i].espera_max,
+			media(v[i].retencion_total, v[i].adquisiciones),
+			v[i].retencion_max, v[i].max_esperando,
+			v[i].reentradas);
+	return 0;
+}
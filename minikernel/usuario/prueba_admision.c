@@ -0,0 +1,97 @@
+/*
+ * usuario/prueba_admision.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba crear_proceso_esp. Un proceso auxiliar
+ * llena la tabla de procesos con procesos que duermen y termina, dejandolos
+ * huerfanos. Despues se comprueba que sin espera se falla al momento, que
+ * con plazo se falla al vencer y que sin plazo se espera a que terminen.
+ * Al final la tabla la llenan sus propios hijos, que no liberan su entrada
+ * hasta que los recoge, y se comprueba que en lugar de esperar se le pide
+ * (-4) que recoja alguno.
+ * El mismo programa hace de proceso auxiliar y de proceso que duerme segun
+ * su primer argumento ("r" o "d").
+ */
+
+#include "servicios.h"
+
+#define SEGS_DORMIR 2
+#define TOT_ESPERA 3
+#define TOT_LANZAR 20	/* mas de los que caben en la tabla */
+
+static char *args_dormir[]={"d", 0};
+static char *args_rellenar[]={"r", 0};
+
+static atrib_proceso dormir_atr={0, 0, 0, 1, args_dormir};
+static atrib_proceso rellenar_atr={0, 0, 0, 1, args_rellenar};
+
+/* crea procesos que duermen hasta que la tabla este llena */
+static int rellenar(){
+	int n=0;
+
+	while (crear_proceso_esp("prueba_admision", &dormir_atr, 0)>=0)
+		n++;
+	return n;
+}
+
+int main(){
+	int argc, i, n, t0, res, pid, estado, recogidos;
+	char **argv;
+
+	obtener_args(&argc, &argv);
+	if (argc>0 && argv[0][0]=='d'){
+		dormir(SEGS_DORMIR);
+		return 0;
+	}
+	if (argc>0 && argv[0][0]=='r'){
+		printf("prueba_admision: %d procesos rellenan la tabla\n",
+			rellenar());
+		return 0;
+	}
+
+	printf("prueba_admision: comienza\n");
+	t0=obtener_tiempo();
+	pid=crear_proceso_ext("prueba_admision", &rellenar_atr);
+	esperar_proceso(pid, &estado);
+	n=rellenar();	/* ocupa la entrada que ha dejado el auxiliar */
+
+	res=crear_proceso_esp("prueba_admision", &dormir_atr, 0);
+	printf("prueba_admision: sin espera devuelve %d. DEBE SER -1\n", res);
+
+	res=crear_proceso_esp("prueba_admision", &dormir_atr, 1);
+	printf("prueba_admision: con plazo de 1 s devuelve %d a los %d ms. DEBE SER -2\n",
+		res, obtener_tiempo()-t0);
+
+	for (i=0; i<TOT_ESPERA; i++){
+		res=crear_proceso_esp("prueba_admision", &dormir_atr, -1);
+		printf("prueba_admision: sin plazo crea %d a los %d ms\n",
+			res, obtener_tiempo()-t0);
+	}
+
+	for (i=0; i<n+TOT_ESPERA; i++)
+		esperar_proceso(-1, &estado);
+
+	/* ahora son sus propios hijos los que llenan la tabla */
+	t0=obtener_tiempo();
+	recogidos=0;
+	for (i=0; i<TOT_LANZAR; i++){
+		while ((res=crear_proceso_esp("prueba_admision", &dormir_atr, -1))==-4){
+			esperar_proceso(-1, &estado);
+			recogidos++;
+		}
+		if (res<0)
+			printf("error lanzando con sus hijos en la tabla: %d. NO DEBE APARECER\n", res);
+	}
+	while (esperar_proceso(-1, &estado)>=0)
+		recogidos++;
+	printf("prueba_admision: lanza %d y recoge %d a los %d ms. DEBEN SER %d\n",
+		i, recogidos, obtener_tiempo()-t0, TOT_LANZAR);
+	printf("prueba_admision: termina\n");
+	return 0;
+}
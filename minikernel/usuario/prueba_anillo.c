@@ -0,0 +1,83 @@
+/*
+ * usuario/prueba_anillo.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las operaciones asincronas: un hilo
+ * envia a la vez una escritura, un dormir y un lock de un mutex que tiene
+ * el hilo principal, sigue trabajando mientras el nucleo las completa y
+ * al final espera a que terminen todas con una sola llamada
+ */
+
+#include "servicios.h"
+
+#define DATO_ESCRIBIR 1
+#define DATO_DORMIR 2
+#define DATO_LOCK 3
+
+anillo_envio envio;
+anillo_fin fin;
+int mutex;
+
+char mensaje[]="hilo: escritura asincrona\n";
+
+void asincrono(void *arg){
+	fin_anillo res;
+	int i, n, t0, vueltas=0;
+
+	if (registrar_anillos(&envio, &fin)<0)
+		printf("error registrando anillos. NO DEBE APARECER\n");
+
+	preparar_op(&envio, OP_ESCRIBIR, (long)mensaje, sizeof(mensaje)-1,
+		DATO_ESCRIBIR);
+	preparar_op(&envio, OP_DORMIR, 1, 0, DATO_DORMIR);
+	preparar_op(&envio, OP_LOCK, mutex, 0, DATO_LOCK);
+
+	t0=obtener_tiempo();
+	if ((n=enviar_anillo(0))!=3)
+		printf("enviadas %d operaciones. NO DEBE APARECER\n", n);
+
+	/* trabajo util mientras se completan */
+	while (fin.cola - fin.cabeza < 2)
+		vueltas++;
+	printf("hilo: %d vueltas de trabajo hasta los %d ms (DEBE SER 1000 APROX.)\n",
+		vueltas, obtener_tiempo()-t0);
+
+	/* espera a las 3 finalizaciones con una sola llamada */
+	enviar_anillo(3);
+	for (i=0; i<3 && recoger_fin(&fin, &res); i++)
+		printf("hilo: termina operacion %d con resultado %d\n",
+			(int)res.dato, (int)res.resultado);
+
+	if (unlock(mutex)<0)
+		printf("el lock asincrono no dio el mutex. NO DEBE APARECER\n");
+	registrar_anillos(0, 0);
+}
+
+int main(){
+	int hilo, estado;
+
+	printf("prueba_anillo: comienza\n");
+
+	if ((mutex=crear_mutex("anillo", NO_RECURSIVO))<0)
+		printf("error creando mutex. NO DEBE APARECER\n");
+	if (lock(mutex)<0)
+		printf("error en lock de mutex. NO DEBE APARECER\n");
+
+	if ((hilo=crear_hilo(asincrono, 0))<0)
+		printf("Error creando hilo\n");
+
+	/* suelta el mutex despues de que termine el dormir del hilo */
+	dormir(2);
+	printf("prueba_anillo: suelta el mutex\n");
+	unlock(mutex);
+
+	esperar_proceso(hilo, &estado);
+	printf("prueba_anillo: termina\n");
+	return 0;
+}
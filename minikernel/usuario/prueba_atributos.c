@@ -0,0 +1,51 @@
+/*
+ * usuario/prueba_atributos.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la llamada
+ * crear_proceso_ext: lanza el mismo programa con distintos argumentos,
+ * pila reducida y distintas prioridades
+ */
+
+#include "servicios.h"
+
+int main(){
+	char *args_lento[]={"lento", "20000000"};
+	char *args_rapido[]={"rapido", "20000000"};
+	atrib_proceso atrib={0};
+	int pid, estado;
+
+	printf("prueba_atributos: comienza\n");
+
+	/* pila de 8 KB y prioridad baja */
+	atrib.tam_pila=8192;
+	atrib.prioridad=PRIO_MIN;
+	atrib.argc=2;
+	atrib.argv=args_lento;
+	if (crear_proceso_ext("trabajador", &atrib)<0)
+		printf("Error creando trabajador lento\n");
+
+	/* prioridad alta y rodaja larga: debe terminar antes que lento */
+	atrib.prioridad=PRIO_MAX;
+	atrib.rodaja=50;
+	atrib.argv=args_rapido;
+	if (crear_proceso_ext("trabajador", &atrib)<0)
+		printf("Error creando trabajador rapido\n");
+
+	/* pila menor que el minimo: error */
+	atrib.tam_pila=1024;
+	if (crear_proceso_ext("trabajador", &atrib)<0)
+		printf("error creando trabajador con pila de 1 KB. DEBE APARECER\n");
+
+	while ((pid=esperar_proceso(-1, &estado))>=0)
+		printf("prueba_atributos: termina proceso %d\n", pid);
+
+	printf("prueba_atributos: termina\n");
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * usuario/prueba_descriptores.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la tabla de descriptores de mutex del
+ * proceso: la llena abriendo el mismo mutex hasta que falla, comprueba
+ * que lock y unlock funcionan en el último descriptor y que, al cerrar
+ * dos, se reutiliza primero el más bajo. Para que la tabla tenga más de
+ * un bloque, se compila el núcleo con otro límite (p.ej. make
+ * DESC_MUTEX=64 en minikernel).
+ */
+
+#include "servicios.h"
+
+#define MAX_DESC 1024	/* maximo que admite el nucleo */
+
+int main(){
+	int n, desc, base;
+
+	printf("prueba_descriptores comienza\n");
+
+	if ((base=crear_mutex("base", NO_RECURSIVO))<0)
+		printf("error creando base. NO DEBE APARECER\n");
+
+	/* cada apertura ocupa el descriptor libre mas bajo */
+	for (n=1; n<MAX_DESC; n++){
+		if ((desc=abrir_mutex("base"))<0)
+			break;
+		if (desc!=n)
+			printf("abierto en %d en lugar de %d. NO DEBE APARECER\n",
+				desc, n);
+	}
+	printf("prueba_descriptores: %d descriptores abiertos\n", n);
+
+	if (lock(n-1)<0 || unlock(n-1)<0)
+		printf("error en lock del ultimo descriptor. NO DEBE APARECER\n");
+
+	if (n>3){
+		cerrar_mutex(n-1);
+		cerrar_mutex(1);
+		desc=abrir_mutex("base");
+		printf("prueba_descriptores: reabierto en %d (DEBE SER 1)\n", desc);
+		desc=abrir_mutex("base");
+		printf("prueba_descriptores: reabierto en %d (DEBE SER %d)\n",
+			desc, n-1);
+	}
+	if (abrir_mutex("base")>=0)
+		printf("abierto con la tabla llena. NO DEBE APARECER\n");
+
+	for (desc=0; desc<n; desc++)
+		cerrar_mutex(desc);
+	if (abrir_mutex("base")>=0)
+		printf("abierto tras cerrarlo todo. NO DEBE APARECER\n");
+
+	printf("prueba_descriptores termina\n");
+	return 0;
+}
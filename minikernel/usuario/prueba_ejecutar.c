@@ -0,0 +1,33 @@
+/*
+ * usuario/prueba_ejecutar.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la llamada ejecutar:
+ * abre un mutex y pasa a ejecutar el programa etapa conservándolo
+ */
+
+#include "servicios.h"
+
+int main(){
+	int desc;
+
+	printf("prueba_ejecutar (%d): comienza\n", obtener_id_pr());
+
+	if ((desc=crear_mutex("etapa", NO_RECURSIVO))<0)
+		printf("error creando mutex etapa. NO DEBE APARECER\n");
+
+	if (ejecutar("noexiste", 1)<0)
+		printf("error ejecutando noexiste. DEBE APARECER\n");
+
+	/* no debe volver: etapa usa el descriptor que se conserva */
+	ejecutar("etapa", 1);
+
+	printf("prueba_ejecutar: ha vuelto de ejecutar. NO DEBE APARECER\n");
+	return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * usuario/prueba_esperar.c
+ *
+ *  Minikernel. Versi�n 1.0
+ *
+ *  Fernando P�rez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la llamada esperar_proceso
+ */
+
+#include "servicios.h"
+
+int main(){
+	int pid_simplon, pid_arit, pid, estado;
+
+	printf("prueba_esperar: comienza\n");
+
+	if ((pid_simplon=crear_proceso("simplon"))<0)
+		printf("Error creando simplon\n");
+
+	if ((pid_arit=crear_proceso("excep_arit"))<0)
+		printf("Error creando excep_arit\n");
+
+	/* espera a un hijo concreto aunque el otro termine antes */
+	pid=esperar_proceso(pid_arit, &estado);
+	printf("prueba_esperar: termina excep_arit (%d) con estado %d. DEBE SER -1\n",
+		pid, estado);
+
+	/* el otro hijo ya ha terminado: no debe bloquearse */
+	pid=esperar_proceso(-1, &estado);
+	printf("prueba_esperar: termina simplon (%d==%d) con estado %d\n",
+		pid, pid_simplon, estado);
+
+	/* no quedan hijos: error */
+	if (esperar_proceso(-1, &estado)<0)
+		printf("prueba_esperar: no quedan hijos. DEBE APARECER\n");
+
+	printf("prueba_esperar: termina con estado 3\n");
+	salir(3);
+	return 0; /* No se deber�a llegar a este punto */
+}
@@ -0,0 +1,70 @@
+/*
+ * usuario/prueba_eventos.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba esperar_eventos. Un hilo bloquea dos
+ * mutex y los va soltando; mientras, el proceso espera con una sola
+ * llamada a que quede libre alguno de ellos, a que se pulse una tecla o
+ * a que venza un plazo. Hay que pulsar una tecla hacia el segundo 1,5.
+ */
+
+#include "servicios.h"
+
+int m1, m2;
+
+void hilo(void *arg){
+
+	lock(m1);
+	lock(m2);
+	dormir(1);
+	printf("hilo: suelta m2\n");
+	unlock(m2);
+	dormir(1);
+	printf("hilo: suelta m1\n");
+	unlock(m1);
+}
+
+void esperar(char *que, int conjunto, int timeout, int t0){
+	int listos;
+
+	listos=esperar_eventos(conjunto, timeout);
+	printf("prueba_eventos: %s -> %d a los %d ms\n", que, listos,
+		obtener_tiempo()-t0);
+}
+
+int main(){
+	int t0;
+
+	m1=crear_mutex("ev1", NO_RECURSIVO);
+	m2=crear_mutex("ev2", NO_RECURSIVO);
+	t0=obtener_tiempo();
+	esperar("consulta (DEBE SER 3)", EV_MUTEX(m1)|EV_MUTEX(m2), 0, t0);
+
+	crear_hilo(hilo, 0);
+	esperar("solo plazo (DEBE SER 0 A LOS 100)", 0, 100, t0);
+	esperar("m1, m2 o terminal (DEBE SER 2 A LOS 1000)",
+		EV_MUTEX(m1)|EV_MUTEX(m2)|EV_TERMINAL, -1, t0);
+	lock(m2);
+	esperar("m1 o terminal, plazo 300 (DEBE SER 0 A LOS 1300)",
+		EV_MUTEX(m1)|EV_TERMINAL, 300, t0);
+	esperar("m1 o terminal (DEBE SER 16 AL PULSAR)",
+		EV_MUTEX(m1)|EV_TERMINAL, 5000, t0);
+	printf("prueba_eventos: tecla %c\n", leer_caracter());
+	esperar("m1 (DEBE SER 1 A LOS 2000)", EV_MUTEX(m1), -1, t0);
+	lock(m1);
+	unlock(m1);
+	unlock(m2);
+
+	if (esperar_eventos(EV_MUTEX(3), 0)!=-1)
+		printf("descriptor no abierto aceptado. NO DEBE APARECER\n");
+	if (esperar_eventos(0, -1)!=-1)
+		printf("conjunto vacio sin plazo aceptado. NO DEBE APARECER\n");
+	printf("prueba_eventos: termina\n");
+	return 0;
+}
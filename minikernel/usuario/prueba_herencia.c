@@ -0,0 +1,104 @@
+/*
+ * usuario/prueba_herencia.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la herencia de prioridad de los mutex.
+ * El proceso inicial (prioridad 10) bloquea el mutex "A"; un proceso
+ * "enlace" (prioridad 10) bloquea "B" y espera por "A"; un proceso "alta"
+ * (prioridad 15) espera por "B" y otro "media" (prioridad 12) se queda
+ * calculando dos segundos. Por herencia, a traves de la cadena, el
+ * proceso inicial y enlace pasan a prioridad 15, no les expulsa media y
+ * alta consigue "B" mucho antes de que media termine. Sin herencia, alta
+ * tendria que esperar a que terminara media.
+ */
+
+#include "servicios.h"
+
+static void calcular(int ms){
+	int t0=obtener_tiempo();
+
+	while (obtener_tiempo()-t0 < ms)
+		;
+}
+
+static void enlace(){
+	int a, b;
+
+	a=abrir_mutex("A");
+	b=crear_mutex("B", NO_RECURSIVO);
+	lock(b);
+	lock(a);
+	printf("enlace: consigue A\n");
+	unlock(a);
+	unlock(b);
+}
+
+static void alta(){
+	int b;
+
+	b=abrir_mutex("B");
+	lock(b);
+	printf("alta: consigue B en el instante %d (DEBE SER ANTES DE QUE TERMINE MEDIA)\n",
+		obtener_tiempo());
+	unlock(b);
+}
+
+int main(){
+	char *args_enlace[]={"enlace"};
+	char *args_alta[]={"alta"};
+	char *args_media[]={"media"};
+	atrib_proceso atrib={0};
+	int argc, a, pid, estado;
+	char **argv;
+
+	/* el mismo programa hace los cuatro papeles segun su argumento */
+	obtener_args(&argc, &argv);
+	if (argc>0){
+		switch (argv[0][0]){
+		case 'e':
+			enlace();
+			break;
+		case 'a':
+			alta();
+			break;
+		case 'm':
+			calcular(2000);
+			printf("media: termina en el instante %d\n", obtener_tiempo());
+			break;
+		}
+		return 0;
+	}
+
+	printf("prueba_herencia: comienza en el instante %d\n", obtener_tiempo());
+	a=crear_mutex("A", NO_RECURSIVO);
+	lock(a);
+
+	atrib.argc=1;
+	atrib.argv=args_enlace;
+	crear_proceso_ext("prueba_herencia", &atrib);
+	esperar_eventos(0, 50);		/* deja que enlace espere por A */
+
+	atrib.argv=args_alta;
+	atrib.prioridad=15;
+	crear_proceso_ext("prueba_herencia", &atrib);
+
+	atrib.argc=1;
+	atrib.argv=args_media;
+	atrib.prioridad=12;
+	crear_proceso_ext("prueba_herencia", &atrib);
+
+	calcular(500);
+	printf("prueba_herencia: suelta A en el instante %d\n", obtener_tiempo());
+	unlock(a);
+
+	while ((pid=esperar_proceso(-1, &estado))>=0)
+		;
+	printf("prueba_herencia: termina\n");
+	return 0;
+}
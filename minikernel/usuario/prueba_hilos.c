@@ -0,0 +1,58 @@
+/*
+ * usuario/prueba_hilos.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que realiza una prueba de la llamada crear_hilo:
+ * varios hilos incrementan un contador compartido protegido con un mutex
+ */
+
+#include "servicios.h"
+
+#define NUM_HILOS 3
+#define TOT_ITER 5
+
+int contador=0;
+int mutex;
+
+void trabajador(void *arg){
+	int i, num=(long)arg;
+
+	for (i=0; i<TOT_ITER; i++){
+		if (lock(mutex)<0)
+			printf("error en lock de mutex. NO DEBE APARECER\n");
+		contador++;
+		printf("hilo %d (%d): contador %d\n", num, obtener_id_pr(), contador);
+		if (unlock(mutex)<0)
+			printf("error en unlock de mutex. NO DEBE APARECER\n");
+	}
+}
+
+int main(){
+	int hilos[NUM_HILOS];
+	int i, estado;
+
+	printf("prueba_hilos: comienza\n");
+
+	if ((mutex=crear_mutex("contador", NO_RECURSIVO))<0)
+		printf("error creando mutex. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_HILOS; i++)
+		if ((hilos[i]=crear_hilo(trabajador, (void *)(long)i))<0)
+			printf("Error creando hilo %d\n", i);
+
+	if (ejecutar("simplon", 0)<0)
+		printf("ejecutar con hilos vivos. DEBE APARECER\n");
+
+	for (i=0; i<NUM_HILOS; i++)
+		esperar_proceso(hilos[i], &estado);
+
+	printf("prueba_hilos: contador final %d. DEBE SER %d\n",
+		contador, NUM_HILOS*TOT_ITER);
+	return 0;
+}
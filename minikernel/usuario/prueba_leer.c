@@ -0,0 +1,46 @@
+/*
+ * usuario/prueba_leer.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las lecturas del terminal que devuelven
+ * varios caracteres por llamada: lee una línea con leer_linea y luego,
+ * con leer, lo que se haya tecleado. Después duerme para que, si se
+ * teclea mucho mientras tanto, se llene el buffer del terminal, y muestra
+ * sus estadísticas (los caracteres perdidos).
+ */
+
+#include "servicios.h"
+
+int main(){
+	char buf[64];
+	estad_term estad;
+	int n;
+
+	printf("prueba_leer: escribe una linea: ");
+	n=leer_linea(buf, sizeof(buf));
+	printf("prueba_leer: leer_linea devuelve %d: %s", n, buf);
+	if (n>0 && buf[n-1]!='\n')
+		printf("\n");
+
+	printf("prueba_leer: escribe algo mas: ");
+	n=leer(buf, sizeof(buf)-1);
+	buf[n>0?n:0]='\0';
+	printf("\nprueba_leer: leer devuelve %d: %s\n", n, buf);
+
+	printf("prueba_leer: duerme 3 segundos; teclea mucho mientras\n");
+	dormir(3);
+	n=leer(buf, sizeof(buf)-1);
+	buf[n>0?n:0]='\0';
+	printf("prueba_leer: en el buffer habia %d: %s\n", n, buf);
+
+	estad_terminal(&estad);
+	printf("prueba_leer: recibidos %u leidos %u perdidos %u pendientes %u\n",
+		estad.recibidos, estad.leidos, estad.perdidos, estad.pendientes);
+	return 0;
+}
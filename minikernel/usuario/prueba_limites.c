@@ -0,0 +1,94 @@
+/*
+ * usuario/prueba_limites.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los limites de recursos. Crea una copia
+ * de si mismo por cada limite, que lo fija y lo supera, y comprueba que
+ * el nucleo la termina con el motivo correspondiente. El primer argumento
+ * indica que limite prueba cada copia ("nada" para los hijos que crean).
+ */
+
+#include "servicios.h"
+
+static char *pruebas[]={"cpu", "hijos", "mutex", "pila"};
+static int motivos[]={FIN_LIMITE_CPU, FIN_LIMITE_HIJOS, FIN_LIMITE_MUTEX,
+	FIN_LIMITE_PILA};
+
+#define NUM_PRUEBAS (sizeof(pruebas)/sizeof(pruebas[0]))
+
+/* los hijos de las pruebas terminan sin hacer nada */
+static char *args_nada[]={"nada", 0};
+
+static void superar(char *prueba){
+	limites_proceso lim;
+	atrib_proceso atr={0, 0, 0, 1, args_nada};
+	int i;
+
+	obtener_limites(&lim);	/* los heredados se mantienen */
+	switch (prueba[0]){
+	case 'c':	/* bucle sin fin como el de mudo */
+		lim.max_ticks=20;
+		if (fijar_limites(&lim)<0)
+			printf("error fijando limites. NO DEBE APARECER\n");
+		for (;;);
+	case 'h':
+		lim.max_hijos=2;
+		fijar_limites(&lim);
+		for (i=0; i<3; i++)
+			crear_proceso_ext("prueba_limites", &atr);
+		break;
+	case 'm':
+		lim.max_mutex=1;
+		fijar_limites(&lim);
+		crear_mutex("limite1", NO_RECURSIVO);
+		crear_mutex("limite2", NO_RECURSIVO);
+		break;
+	case 'p':
+		lim.max_pila=16384;
+		fijar_limites(&lim);
+		atr.tam_pila=32768;
+		crear_proceso_ext("prueba_limites", &atr);
+		break;
+	}
+}
+
+int main(){
+	int argc, i, pid, estado;
+	char **argv;
+	char *args[2]={0, 0};
+	atrib_proceso atr={0, 0, 0, 1, args};
+	limites_proceso lim={0, 0, 0, 0};
+
+	obtener_args(&argc, &argv);
+	if (argc>0 && argv[0][0]=='n')
+		return 0;
+	if (argc>0){
+		superar(argv[0]);
+		printf("%s: no se ha superado el limite. NO DEBE APARECER\n",
+			argv[0]);
+		return 0;
+	}
+
+	printf("prueba_limites: comienza\n");
+	lim.max_hijos=NUM_PRUEBAS;
+	fijar_limites(&lim);
+	lim.max_hijos=0;
+	if (fijar_limites(&lim)==0)
+		printf("se ha quitado un limite. NO DEBE APARECER\n");
+
+	for (i=0; i<NUM_PRUEBAS; i++){
+		args[0]=pruebas[i];
+		pid=crear_proceso_ext("prueba_limites", &atr);
+		esperar_proceso(pid, &estado);
+		printf("prueba_limites: %s termina con estado %d. DEBE SER %d\n",
+			pruebas[i], estado, motivos[i]);
+	}
+	printf("prueba_limites: termina\n");
+	return 0;
+}
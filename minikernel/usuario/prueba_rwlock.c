@@ -0,0 +1,127 @@
+/*
+ * usuario/prueba_rwlock.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los rwlock con varios hilos: que los
+ * lectores entran a la vez, que con PREF_ESCRITOR un lector nuevo espera
+ * detras del escritor que espera y que, al salir este, entran juntos
+ * todos los lectores que esperaban, y que con PREF_LECTOR no espera.
+ */
+
+#include "servicios.h"
+
+int rw;
+int dentro=0, max_dentro=0;
+char traza[16];
+int long_traza=0;
+
+static void anotar(char c){
+	traza[long_traza++]=c;
+	traza[long_traza]='\0';
+}
+
+static void pausa(int ms){
+	esperar_eventos(0, ms);
+}
+
+void lector(void *arg){
+
+	if (lock_lectura(rw)<0)
+		printf("error en lock_lectura. NO DEBE APARECER\n");
+	anotar('L');
+	if (++dentro>max_dentro)
+		max_dentro=dentro;
+	pausa((long)arg);
+	dentro--;
+	unlock_rw(rw);
+}
+
+void escritor(void *arg){
+
+	if (lock_escritura(rw)<0)
+		printf("error en lock_escritura. NO DEBE APARECER\n");
+	anotar('E');
+	if (dentro!=0)
+		printf("escritor con lectores dentro. NO DEBE APARECER\n");
+	pausa((long)arg);
+	unlock_rw(rw);
+}
+
+static void esperar_hilos(int *hilos, int n){
+	int i, estado;
+
+	for (i=0; i<n; i++)
+		esperar_proceso(hilos[i], &estado);
+}
+
+static void reiniciar(){
+	dentro=max_dentro=0;
+	long_traza=0;
+	traza[0]='\0';
+}
+
+int main(){
+	int hilos[4];
+	int i;
+
+	printf("prueba_rwlock: comienza\n");
+	if ((rw=crear_rwlock("datos", PREF_ESCRITOR))<0)
+		printf("error creando rwlock. NO DEBE APARECER\n");
+
+	/* los lectores entran a la vez */
+	for (i=0; i<3; i++)
+		hilos[i]=crear_hilo(lector, (void *)200);
+	esperar_hilos(hilos, 3);
+	printf("prueba_rwlock: %d lectores a la vez (DEBE SER 3)\n", max_dentro);
+
+	/* PREF_ESCRITOR: los lectores nuevos esperan detras del escritor y
+	   entran juntos cuando sale */
+	reiniciar();
+	lock_lectura(rw);
+	hilos[0]=crear_hilo(escritor, (void *)100);
+	pausa(50);
+	hilos[1]=crear_hilo(lector, (void *)100);
+	hilos[2]=crear_hilo(lector, (void *)100);
+	pausa(50);
+	printf("prueba_rwlock: con el escritor esperando entran \"%s\" (DEBE SER \"\")\n",
+		traza);
+	unlock_rw(rw);
+	esperar_hilos(hilos, 3);
+	printf("prueba_rwlock: orden \"%s\" con %d lectores a la vez (DEBE SER \"ELL\" CON 2)\n",
+		traza, max_dentro);
+
+	/* errores */
+	if (lock(rw)!=-1 || unlock(rw)!=-1)
+		printf("lock o unlock de un rwlock sin error. NO DEBE APARECER\n");
+	if (abrir_mutex("datos")!=-1)
+		printf("abrir_mutex de un rwlock sin error. NO DEBE APARECER\n");
+	if (unlock_rw(rw)!=-2)
+		printf("unlock_rw sin tenerlo sin error. NO DEBE APARECER\n");
+	lock_lectura(rw);
+	if (lock_escritura(rw)!=-2)
+		printf("lock_escritura con una lectura sin error. NO DEBE APARECER\n");
+	unlock_rw(rw);
+	cerrar_rwlock(rw);
+
+	/* PREF_LECTOR: el lector no espera aunque espere un escritor */
+	reiniciar();
+	if ((rw=crear_rwlock("datos", PREF_LECTOR))<0)
+		printf("error creando rwlock. NO DEBE APARECER\n");
+	lock_lectura(rw);
+	hilos[0]=crear_hilo(escritor, (void *)0);
+	pausa(50);
+	hilos[1]=crear_hilo(lector, (void *)0);
+	pausa(50);
+	unlock_rw(rw);
+	esperar_hilos(hilos, 2);
+	printf("prueba_rwlock: con PREF_LECTOR orden \"%s\" (DEBE SER \"LE\")\n", traza);
+
+	printf("prueba_rwlock: termina\n");
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * usuario/prueba_salida.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que escribe sin buffer una ráfaga de líneas que no
+ * cabe en la cola de salida del núcleo. Las primeras llamadas vuelven sin
+ * esperar al terminal; cuando la cola se llena, el proceso se bloquea
+ * hasta que se vacía. Todas las líneas deben aparecer, y en orden.
+ */
+
+#include "servicios.h"
+
+#define TOT_LINEAS 200		/* de 64 bytes: más de 3 veces la cola */
+
+int main(){
+	char linea[64];
+	int i, j, t0, t1, lento=0, max=0;
+
+	fijar_buffer(SIN_BUFFER);
+	for (j=0; j<sizeof(linea)-1; j++)
+		linea[j]='.';
+	linea[sizeof(linea)-1]='\n';
+
+	for (i=0; i<TOT_LINEAS; i++){
+		linea[0]='0'+(i/100)%10;
+		linea[1]='0'+(i/10)%10;
+		linea[2]='0'+i%10;
+		t0=obtener_tiempo();
+		escribir(linea, sizeof(linea));
+		t1=obtener_tiempo();
+		if (t1-t0>max)
+			max=t1-t0;
+		if (t1-t0>0)
+			lento++;
+	}
+	printf("prueba_salida: %d de %d escrituras tardan algo (maximo %d ms)\n",
+		lento, TOT_LINEAS, max);
+	return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * usuario/prueba_semaforos.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba los semaforos y las variables condicion
+ * con varios hilos: un productor y un consumidor con un buffer acotado,
+ * un sem_subir_n que da paso de una vez a varios que esperan y un
+ * cond_broadcast que pasa a los que esperan a la cola del mutex sin
+ * despertarlos hasta que este queda libre. Por ultimo, que cond_wait falla
+ * si se destruye el mutex mientras espera, aunque su entrada se reutilice.
+ */
+
+#include "servicios.h"
+
+#define TAM_BUF 4
+#define NUM_DATOS 20
+
+int buf[TAM_BUF];
+int huecos, llenos, mutex, lote, cond;
+int suma=0, en_orden=1;
+int entrados=0, dentro=0, max_dentro=0, listo=0;
+int res_cond;
+
+void productor(void *arg){
+	int i;
+
+	for (i=0; i<NUM_DATOS; i++){
+		sem_bajar(huecos);
+		buf[i%TAM_BUF]=i;
+		sem_subir(llenos);
+	}
+}
+
+void consumidor(void *arg){
+	int i, dato;
+
+	for (i=0; i<NUM_DATOS; i++){
+		sem_bajar(llenos);
+		dato=buf[i%TAM_BUF];
+		sem_subir(huecos);
+		if (dato!=i)
+			en_orden=0;
+		suma+=dato;
+	}
+}
+
+void esperar_lote(void *arg){
+
+	if (sem_bajar(lote)<0)
+		printf("error en sem_bajar. NO DEBE APARECER\n");
+	entrados++;
+}
+
+void esperar_condicion(void *arg){
+
+	lock(mutex);
+	while (!listo)
+		if (cond_wait(cond, mutex)<0)
+			printf("error en cond_wait. NO DEBE APARECER\n");
+	entrados++;
+	if (++dentro>max_dentro)
+		max_dentro=dentro;
+	esperar_eventos(0, 20);
+	dentro--;
+	unlock(mutex);
+}
+
+void esperar_sin_mutex(void *arg){
+
+	lock(mutex);
+	res_cond=cond_wait(cond, mutex);
+}
+
+static void esperar_hilos(int *hilos, int n){
+	int i, estado;
+
+	for (i=0; i<n; i++)
+		esperar_proceso(hilos[i], &estado);
+}
+
+int main(){
+	int hilos[3];
+	int i, n, otro;
+
+	printf("prueba_semaforos: comienza\n");
+
+	/* productor-consumidor sin sondear con dormir */
+	huecos=crear_semaforo("huecos", TAM_BUF);
+	llenos=crear_semaforo("llenos", 0);
+	hilos[0]=crear_hilo(consumidor, 0);
+	hilos[1]=crear_hilo(productor, 0);
+	esperar_hilos(hilos, 2);
+	printf("prueba_semaforos: suma %d %s (DEBE SER 190 en orden)\n",
+		suma, en_orden ? "en orden" : "desordenada");
+	cerrar_semaforo(huecos);
+	cerrar_semaforo(llenos);
+
+	/* un solo sem_subir_n da paso a los tres */
+	lote=crear_semaforo("lote", 0);
+	for (i=0; i<3; i++)
+		hilos[i]=crear_hilo(esperar_lote, 0);
+	esperar_eventos(0, 50);
+	printf("prueba_semaforos: antes de subir entran %d (DEBE SER 0)\n", entrados);
+	sem_subir_n(lote, 3);
+	esperar_hilos(hilos, 3);
+	printf("prueba_semaforos: despues de subir entran %d (DEBE SER 3)\n", entrados);
+	if (sem_subir_n(lote, 0)!=-1 || sem_bajar(99)!=-1)
+		printf("sem_subir_n de 0 o sem_bajar sin semaforo sin error. NO DEBE APARECER\n");
+	cerrar_semaforo(lote);
+
+	/* cond_broadcast pasa a los tres a esperar por el mutex */
+	entrados=0;
+	mutex=crear_mutex("mutex", NO_RECURSIVO);
+	cond=crear_condicion("cond");
+	if (cond_wait(cond, mutex)!=-2)
+		printf("cond_wait sin tener el mutex sin error. NO DEBE APARECER\n");
+	for (i=0; i<3; i++)
+		hilos[i]=crear_hilo(esperar_condicion, 0);
+	esperar_eventos(0, 50);
+	lock(mutex);
+	listo=1;
+	n=cond_broadcast(cond);
+	esperar_eventos(0, 50);
+	printf("prueba_semaforos: broadcast a %d, con el mutex cogido entran %d (DEBE SER 3 Y 0)\n",
+		n, entrados);
+	unlock(mutex);
+	esperar_hilos(hilos, 3);
+	printf("prueba_semaforos: entran %d, %d a la vez (DEBE SER 3, 1 a la vez)\n",
+		entrados, max_dentro);
+	if (cond_signal(cond)!=0)
+		printf("cond_signal sin nadie esperando distinto de 0. NO DEBE APARECER\n");
+
+	/* el mutex se destruye y su entrada se reutiliza mientras espera */
+	hilos[0]=crear_hilo(esperar_sin_mutex, 0);
+	esperar_eventos(0, 50);
+	cerrar_mutex(mutex);
+	otro=crear_mutex("otro", NO_RECURSIVO);
+	n=cond_signal(cond);
+	esperar_hilos(hilos, 1);
+	printf("prueba_semaforos: sin mutex cond_wait devuelve %d y signal a %d (DEBE SER -1 Y 0)\n",
+		res_cond, n);
+	if (trylock(otro)!=0)
+		printf("el mutex nuevo tiene dueno. NO DEBE APARECER\n");
+
+	printf("prueba_semaforos: termina\n");
+	return 0;
+}
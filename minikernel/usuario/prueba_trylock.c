@@ -0,0 +1,58 @@
+/*
+ * usuario/prueba_trylock.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que prueba trylock y lock_timeout. Un hilo tiene
+ * bloqueado el mutex durante un segundo; mientras, el proceso prueba a
+ * cogerlo sin esperar y esperando un plazo que vence antes y otro que
+ * vence después de que el hilo lo suelte.
+ */
+
+#include "servicios.h"
+
+int m;
+
+void hilo(void *arg){
+
+	lock(m);
+	dormir(1);
+	printf("hilo: suelta el mutex\n");
+	unlock(m);
+}
+
+int main(){
+	int t0, res;
+
+	m=crear_mutex("plazo", NO_RECURSIVO);
+	t0=obtener_tiempo();
+	crear_hilo(hilo, 0);
+	esperar_eventos(0, 100);	/* deja que el hilo coja el mutex */
+
+	res=trylock(m);
+	printf("prueba_trylock: trylock -> %d a los %d ms (DEBE SER -3 A LOS 100)\n",
+		res, obtener_tiempo()-t0);
+
+	res=lock_timeout(m, 30);
+	printf("prueba_trylock: lock_timeout(30) -> %d a los %d ms (DEBE SER -3 A LOS 400)\n",
+		res, obtener_tiempo()-t0);
+
+	res=lock_timeout(m, 200);
+	printf("prueba_trylock: lock_timeout(200) -> %d a los %d ms (DEBE SER 0 A LOS 1000)\n",
+		res, obtener_tiempo()-t0);
+
+	if (trylock(m)!=-2)
+		printf("trylock de un mutex propio no recursivo sin error. NO DEBE APARECER\n");
+	unlock(m);
+	if (trylock(m)!=0)
+		printf("trylock de un mutex libre fallido. NO DEBE APARECER\n");
+	unlock(m);
+
+	printf("prueba_trylock: termina\n");
+	return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * usuario/trabajador.c
+ *
+ *  Minikernel. Versión 1.0
+ *
+ *  Fernando Pérez Costoya
+ *
+ */
+
+/*
+ * Programa de usuario que "gasta CPU" según sus argumentos:
+ *	trabajador nombre iteraciones
+ */
+
+#include "servicios.h"
+
+/* convierte una cadena de dígitos en un entero */
+static int a_entero(char *cad){
+	int n=0;
+
+	while (*cad>='0' && *cad<='9')
+		n=n*10+(*cad++ - '0');
+	return n;
+}
+
+int main(){
+	int argc, i, tot=0;
+	char **argv;
+	int iter=1000000;
+	char *nombre="trabajador";
+
+	obtener_args(&argc, &argv);
+	if (argc>0)
+		nombre=argv[0];
+	if (argc>1)
+		iter=a_entero(argv[1]);
+
+	printf("%s (%d): comienza con %d iteraciones\n", nombre,
+		obtener_id_pr(), iter);
+	for (i=0; i<iter; i++)
+		tot+=i%7;
+	printf("%s (%d): termina con %d\n", nombre, obtener_id_pr(), tot);
+	return 0;
+}